@@ -0,0 +1,103 @@
+extends SceneTree
+
+# headless driver for WhisperBenchmark, run through the "benchmark" SCons target or directly:
+#   godot --headless --path bin/benchmark --script res://benchmark.gd -- --model=ggml-base.en.bin --threads=2,4,8
+#
+# options (lists are comma separated, every combination is run):
+#   --model=<path>          ggml model, required
+#   --audio=<path>          .wav/.ogg/.mp3 input, synthetic speech-like audio when omitted
+#   --duration=<s>          length of the synthetic audio (30)
+#   --modes=<list>          transcribe, parallel, stream (all)
+#   --threads=<list>        n_threads (4)
+#   --audio-ctx=<list>      audio_ctx, 0 for the model's (0)
+#   --strategy=<list>       greedy, beam_search (greedy)
+#   --beam-size=<list>      beam sizes for beam_search (5)
+#   --step-ms=<list>        stream step (3000)
+#   --length-ms=<list>      stream window length (10000)
+#   --keep-ms=<ms>          audio kept from the previous stream window (200)
+#   --processors=<n>        transcribe_parallel processors, 0 for auto (0)
+#   --iterations=<n>        measured runs per combination (3)
+#   --warmup=<n>            unmeasured runs per combination (1)
+#   --gpu                   use the gpu
+#   --output=<path>         also write the json report here
+# the report is printed to stdout as json, the exit code is non-zero if anything failed
+
+
+func _parse_ints(value: String) -> PackedInt32Array:
+	var result := PackedInt32Array()
+	for item in value.split(",", false):
+		result.push_back(item.strip_edges().to_int())
+	return result
+
+
+func _parse_strategies(value: String) -> PackedInt32Array:
+	var result := PackedInt32Array()
+	for item in value.split(",", false):
+		result.push_back(1 if item.strip_edges() == "beam_search" else 0)
+	return result
+
+
+func _initialize() -> void:
+	if not ClassDB.class_exists("WhisperBenchmark"):
+		printerr("[benchmark] WhisperBenchmark is not registered, build the extension with benchmark=yes and run with --import once first")
+		quit(1)
+		return
+
+	var options := {}
+	for arg in OS.get_cmdline_user_args():
+		if not arg.begins_with("--"):
+			continue
+		var pair := arg.substr(2).split("=", true, 1)
+		options[pair[0]] = pair[1] if pair.size() > 1 else ""
+
+	if not options.has("model"):
+		printerr("[benchmark] --model=<path> is required")
+		quit(1)
+		return
+
+	var model = ClassDB.instantiate("WhisperModel")
+	model.bin_path = options["model"]
+
+	var benchmark = ClassDB.instantiate("WhisperBenchmark")
+	benchmark.model = model
+	benchmark.use_gpu = options.has("gpu")
+	if options.has("audio"):
+		benchmark.audio_path = options["audio"]
+	if options.has("duration"):
+		benchmark.synthetic_duration_s = options["duration"].to_float()
+	if options.has("modes"):
+		benchmark.modes = options["modes"].split(",", false)
+	if options.has("threads"):
+		benchmark.n_threads_values = _parse_ints(options["threads"])
+	if options.has("audio-ctx"):
+		benchmark.audio_ctx_values = _parse_ints(options["audio-ctx"])
+	if options.has("strategy"):
+		benchmark.strategies = _parse_strategies(options["strategy"])
+	if options.has("beam-size"):
+		benchmark.beam_sizes = _parse_ints(options["beam-size"])
+	if options.has("step-ms"):
+		benchmark.step_ms_values = _parse_ints(options["step-ms"])
+	if options.has("length-ms"):
+		benchmark.length_ms_values = _parse_ints(options["length-ms"])
+	if options.has("keep-ms"):
+		benchmark.keep_ms = options["keep-ms"].to_int()
+	if options.has("processors"):
+		benchmark.n_processors = options["processors"].to_int()
+	if options.has("iterations"):
+		benchmark.iterations = options["iterations"].to_int()
+	if options.has("warmup"):
+		benchmark.warmup_iterations = options["warmup"].to_int()
+
+	var report: Dictionary = benchmark.run()
+	var json := JSON.stringify(report, "\t", false)
+	print(json)
+
+	if options.has("output"):
+		var file := FileAccess.open(options["output"], FileAccess.WRITE)
+		if file:
+			file.store_string(json)
+		else:
+			printerr("[benchmark] failed to write ", options["output"])
+
+	var failed: bool = report.is_empty() or report["runs"].any(func(run): return run.has("error"))
+	quit(1 if failed else 0)
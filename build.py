@@ -9,6 +9,9 @@ thirdparty_dir = "thirdparty/whisper.cpp/"
 
 def _setup_options(opts):
     opts.Add(BoolVariable("use_vulkan", "Enable Vulkan GPU acceleration", False))
+    opts.Add(BoolVariable("benchmark", "Build the WhisperBenchmark class, required by the benchmark target", False))
+    opts.Add("godot", "Godot editor executable used by the benchmark target", "godot")
+    opts.Add("benchmark_args", "Arguments passed to benchmark/benchmark.gd, e.g. \"--model=ggml-base.en.bin --threads=2,4\"", "")
 
 def _process_env(self, env, sources, is_gdextension):
     if env["platform"] == "windows":
@@ -0,0 +1,56 @@
+#include "audio_effect_whisper_capture.h"
+
+#include <godot_cpp/classes/audio_server.hpp>
+#include <godot_cpp/core/class_db.hpp>
+using namespace godot;
+
+#include "whisper_microphone_transcriber.h"
+
+#include <cstring>
+
+/* --- AudioEffectWhisperCaptureInstance implementation --- */
+
+void AudioEffectWhisperCaptureInstance::_bind_methods() {
+}
+
+// audio thread
+void AudioEffectWhisperCaptureInstance::_process(const void *p_src_buffer, AudioFrame *p_dst_buffer, int32_t p_frame_count) {
+	const AudioFrame *src = (const AudioFrame *)p_src_buffer;
+
+	// passes the audio through, the transcriber's own bus is muted anyway
+	if (src != p_dst_buffer) {
+		memcpy(p_dst_buffer, src, p_frame_count * sizeof(AudioFrame));
+	}
+
+	if (base->transcriber) {
+		base->transcriber->_capture_frames(src, p_frame_count);
+	}
+}
+
+// silence is still audio the transcriber has to see, or its timing drifts
+bool AudioEffectWhisperCaptureInstance::_process_silence() const {
+	return true;
+}
+
+/* --- AudioEffectWhisperCapture implementation --- */
+
+void AudioEffectWhisperCapture::_bind_methods() {
+}
+
+void AudioEffectWhisperCapture::set_transcriber(WhisperMicrophoneTranscriber *p_transcriber) {
+	AudioServer *audio_server = AudioServer::get_singleton();
+	if (audio_server) {
+		audio_server->lock();
+	}
+	transcriber = p_transcriber;
+	if (audio_server) {
+		audio_server->unlock();
+	}
+}
+
+Ref<AudioEffectInstance> AudioEffectWhisperCapture::_instantiate() {
+	Ref<AudioEffectWhisperCaptureInstance> instance;
+	instance.instantiate();
+	instance->base = Ref<AudioEffectWhisperCapture>(this);
+	return instance;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <godot_cpp/classes/audio_effect.hpp>
+#include <godot_cpp/classes/audio_effect_instance.hpp>
+#include <godot_cpp/classes/audio_frame.hpp>
+using namespace godot;
+
+class AudioEffectWhisperCapture;
+class WhisperMicrophoneTranscriber;
+
+class AudioEffectWhisperCaptureInstance : public AudioEffectInstance {
+	GDCLASS(AudioEffectWhisperCaptureInstance, AudioEffectInstance);
+
+	friend class AudioEffectWhisperCapture;
+
+	Ref<AudioEffectWhisperCapture> base;
+
+protected:
+	static void _bind_methods();
+
+public:
+	virtual void _process(const void *p_src_buffer, AudioFrame *p_dst_buffer, int32_t p_frame_count) override;
+	virtual bool _process_silence() const override;
+};
+
+// this class hands the frames mixed on its bus to a WhisperMicrophoneTranscriber from the audio thread.
+// unlike polling an AudioEffectCapture, every frame arrives exactly once, one mix block after it was mixed,
+// and nothing is allocated: the transcriber downmixes and resamples straight into its ring buffer.
+// WhisperMicrophoneTranscriber installs it on its own bus, or uses it as the last effect of a custom bus
+class AudioEffectWhisperCapture : public AudioEffect {
+	GDCLASS(AudioEffectWhisperCapture, AudioEffect);
+
+	friend class AudioEffectWhisperCaptureInstance;
+
+	// read by the audio thread, only changed while holding the AudioServer lock
+	WhisperMicrophoneTranscriber *transcriber = nullptr;
+
+protected:
+	static void _bind_methods();
+
+public:
+	// native only, nullptr detaches. takes the AudioServer lock, so no block is in flight when it returns
+	void set_transcriber(WhisperMicrophoneTranscriber *p_transcriber);
+	bool has_transcriber() const { return transcriber != nullptr; }
+
+	virtual Ref<AudioEffectInstance> _instantiate() override;
+};
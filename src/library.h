@@ -1,14 +1,29 @@
 #include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/classes/editor_plugin_registration.hpp>
 #include <godot_cpp/classes/resource_loader.hpp>
 using namespace godot;
 
 #include "whisper_model.h"
 #include "whisper_full.h"
 #include "whisper_microphone_transcriber.h"
+#include "whisper_stream_hub.h"
+#ifdef WHISPER_BENCHMARK
+#include "whisper_benchmark.h"
+#endif
+#include "audio_effect_whisper_capture.h"
+#include "whisper_context_cache.h"
+#include "whisper_model_import_plugin.h"
 
 static Ref<ResourceFormatLoaderWhisperModel> whisper_model_resource_loader;
+static WhisperContextCache *whisper_context_cache = nullptr;
 
 void initialize_library(ModuleInitializationLevel p_level) {
+    if (p_level == MODULE_INITIALIZATION_LEVEL_EDITOR) {
+        GDREGISTER_INTERNAL_CLASS(WhisperModelImportPlugin);
+        GDREGISTER_INTERNAL_CLASS(WhisperEditorPlugin);
+        EditorPlugins::add_by_type<WhisperEditorPlugin>();
+        return;
+    }
     if (p_level != MODULE_INITIALIZATION_LEVEL_SCENE) {
 		return;
 	}
@@ -17,14 +32,27 @@ void initialize_library(ModuleInitializationLevel p_level) {
     GDREGISTER_CLASS(WhisperModel);
     GDREGISTER_CLASS(ResourceFormatLoaderWhisperModel);
     GDREGISTER_CLASS(WhisperSegment);
+    GDREGISTER_CLASS(WhisperJob);
     GDREGISTER_CLASS(WhisperFull);
     GDREGISTER_CLASS(WhisperMicrophoneTranscriber);
+    GDREGISTER_CLASS(WhisperStreamHub);
+#ifdef WHISPER_BENCHMARK
+    GDREGISTER_CLASS(WhisperBenchmark);
+#endif
+    GDREGISTER_CLASS(AudioEffectWhisperCaptureInstance);
+    GDREGISTER_CLASS(AudioEffectWhisperCapture);
+
+    whisper_context_cache = memnew(WhisperContextCache);
 
     whisper_model_resource_loader.instantiate();
     ResourceLoader::get_singleton()->add_resource_format_loader(whisper_model_resource_loader);
 }
 
 void uninitialize_library(ModuleInitializationLevel p_level) {
+    if (p_level == MODULE_INITIALIZATION_LEVEL_EDITOR) {
+        EditorPlugins::remove_by_type<WhisperEditorPlugin>();
+        return;
+    }
     if (p_level != MODULE_INITIALIZATION_LEVEL_SCENE) {
 		return;
 	}
@@ -32,4 +60,7 @@ void uninitialize_library(ModuleInitializationLevel p_level) {
     //
     ResourceLoader::get_singleton()->remove_resource_format_loader(whisper_model_resource_loader);
     whisper_model_resource_loader.unref();
+
+    memdelete(whisper_context_cache);
+    whisper_context_cache = nullptr;
 }
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <godot_cpp/core/memory.hpp>
+using namespace godot;
+
+#include <atomic>
+
+// unbounded lock-free multi-producer / single-consumer queue (Vyukov style).
+// any thread may push, only one thread at a time may pop or check is_empty.
+template <typename T>
+class MPSCQueue {
+	struct Node {
+		std::atomic<Node *> next{ nullptr };
+		T value;
+	};
+
+	std::atomic<Node *> head; // last pushed node, producers swap themselves in here
+	Node *tail = nullptr; // consumer side, always points at a dummy node
+	Node stub;
+
+public:
+	void push(const T &p_value) {
+		Node *node = memnew(Node);
+		node->value = p_value;
+
+		Node *prev = head.exchange(node, std::memory_order_acq_rel);
+		prev->next.store(node, std::memory_order_release);
+	}
+
+	bool pop(T &r_value) {
+		Node *next = tail->next.load(std::memory_order_acquire);
+		if (next == nullptr) {
+			return false;
+		}
+
+		// next becomes the new dummy, its value is moved out
+		r_value = next->value;
+		next->value = T();
+
+		Node *old = tail;
+		tail = next;
+		if (old != &stub) {
+			memdelete(old);
+		}
+		return true;
+	}
+
+	// a single atomic load, cheap enough to call every frame
+	bool is_empty() const {
+		return tail->next.load(std::memory_order_acquire) == nullptr;
+	}
+
+	MPSCQueue() {
+		head.store(&stub, std::memory_order_relaxed);
+		tail = &stub;
+	}
+
+	~MPSCQueue() {
+		T value;
+		while (pop(value)) {
+		}
+		if (tail != &stub) {
+			memdelete(tail);
+		}
+	}
+};
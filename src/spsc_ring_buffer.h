@@ -0,0 +1,88 @@
+#pragma once
+
+#include <godot_cpp/templates/local_vector.hpp>
+using namespace godot;
+
+#include <atomic>
+#include <cstring>
+
+// fixed-capacity lock-free single-producer / single-consumer ring buffer for trivially copyable data.
+// one thread writes, one thread reads; the readable data is exposed as (at most) two contiguous regions,
+// so the consumer can copy straight out of the ring without an intermediate buffer.
+template <typename T>
+class SPSCRingBuffer {
+	LocalVector<T> data;
+	uint32_t mask = 0;
+
+	// free running positions, the difference is the number of readable elements
+	alignas(64) std::atomic<uint32_t> read_pos{ 0 };
+	alignas(64) std::atomic<uint32_t> write_pos{ 0 };
+
+public:
+	// not thread safe, must be called while neither side is active
+	void resize(uint32_t p_capacity) {
+		uint32_t capacity = 1;
+		while (capacity < p_capacity) {
+			capacity <<= 1;
+		}
+
+		data.resize(capacity);
+		mask = capacity - 1;
+		read_pos.store(0, std::memory_order_relaxed);
+		write_pos.store(0, std::memory_order_relaxed);
+	}
+
+	uint32_t get_capacity() const {
+		return data.size();
+	}
+
+	/* --- producer --- */
+
+	// returns how many elements were written, elements that don't fit are dropped
+	uint32_t write(const T *p_data, uint32_t p_count) {
+		uint32_t w = write_pos.load(std::memory_order_relaxed);
+		uint32_t r = read_pos.load(std::memory_order_acquire);
+
+		uint32_t count = MIN(p_count, (uint32_t)data.size() - (w - r));
+		if (count == 0) {
+			return 0;
+		}
+
+		uint32_t index = w & mask;
+		uint32_t first = MIN(count, (uint32_t)data.size() - index);
+		memcpy(data.ptr() + index, p_data, first * sizeof(T));
+		memcpy(data.ptr(), p_data + first, (count - first) * sizeof(T));
+
+		write_pos.store(w + count, std::memory_order_release);
+		return count;
+	}
+
+	/* --- consumer --- */
+
+	uint32_t get_available() const {
+		return write_pos.load(std::memory_order_acquire) - read_pos.load(std::memory_order_relaxed);
+	}
+
+	// readable data, oldest first. the regions stay valid until advance_read
+	uint32_t get_read_regions(const T *&r_first, uint32_t &r_first_count, const T *&r_second, uint32_t &r_second_count) const {
+		uint32_t r = read_pos.load(std::memory_order_relaxed);
+		uint32_t available = write_pos.load(std::memory_order_acquire) - r;
+
+		uint32_t index = r & mask;
+		r_first = data.ptr() + index;
+		r_first_count = MIN(available, (uint32_t)data.size() - index);
+		r_second = data.ptr();
+		r_second_count = available - r_first_count;
+
+		return available;
+	}
+
+	void advance_read(uint32_t p_count) {
+		read_pos.store(read_pos.load(std::memory_order_relaxed) + p_count, std::memory_order_release);
+	}
+
+	// drops everything written so far
+	void clear() {
+		read_pos.store(write_pos.load(std::memory_order_acquire), std::memory_order_release);
+	}
+};
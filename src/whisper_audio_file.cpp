@@ -0,0 +1,199 @@
+#include "whisper_audio_file.h"
+
+#include <godot_cpp/classes/audio_server.hpp>
+#include <godot_cpp/classes/audio_stream_mp3.hpp>
+#include <godot_cpp/classes/audio_stream_ogg_vorbis.hpp>
+#include <godot_cpp/core/error_macros.hpp>
+using namespace godot;
+
+#include <cstring>
+
+// little-endian four character codes
+static const uint32_t WAV_RIFF = 0x46464952; // "RIFF"
+static const uint32_t WAV_WAVE = 0x45564157; // "WAVE"
+static const uint32_t WAV_FMT = 0x20746d66; // "fmt "
+static const uint32_t WAV_DATA = 0x61746164; // "data"
+
+static const int WAV_FORMAT_PCM = 1;
+static const int WAV_FORMAT_FLOAT = 3;
+static const int WAV_FORMAT_EXTENSIBLE = 0xFFFE;
+
+bool WhisperAudioFile::open(const String &p_path) {
+	close();
+
+	String extension = p_path.get_extension().to_lower();
+	if (extension == "wav") {
+		return _open_wav(p_path);
+	}
+
+	if (extension == "ogg") {
+		Ref<AudioStreamOggVorbis> ogg = AudioStreamOggVorbis::load_from_file(p_path);
+		ERR_FAIL_COND_V_MSG(ogg.is_null(), false, "[WhisperAudioFile] failed to load Ogg Vorbis file: " + p_path);
+		ogg->set_loop(false);
+		stream = ogg;
+	} else if (extension == "mp3") {
+		PackedByteArray data = FileAccess::get_file_as_bytes(p_path);
+		ERR_FAIL_COND_V_MSG(data.is_empty(), false, "[WhisperAudioFile] failed to read MP3 file: " + p_path);
+		Ref<AudioStreamMP3> mp3;
+		mp3.instantiate();
+		mp3->set_data(data);
+		mp3->set_loop(false);
+		stream = mp3;
+	} else {
+		ERR_FAIL_V_MSG(false, "[WhisperAudioFile] unsupported audio format: " + p_path);
+	}
+
+	playback = stream->instantiate_playback();
+	ERR_FAIL_COND_V_MSG(playback.is_null(), false, "[WhisperAudioFile] failed to create playback for: " + p_path);
+	playback->start(0.0);
+
+	// playbacks resample to the mix rate of the audio server
+	resampler.setup(int(AudioServer::get_singleton()->get_mix_rate()));
+	return true;
+}
+
+bool WhisperAudioFile::_open_wav(const String &p_path) {
+	file = FileAccess::open(p_path, FileAccess::READ);
+	ERR_FAIL_COND_V_MSG(file.is_null(), false, "[WhisperAudioFile] failed to open file: " + p_path);
+
+	uint32_t riff = file->get_32();
+	file->get_32(); // riff size
+	uint32_t wave = file->get_32();
+	ERR_FAIL_COND_V_MSG(riff != WAV_RIFF || wave != WAV_WAVE, false, "[WhisperAudioFile] not a RIFF/WAVE file: " + p_path);
+
+	int sample_rate = 0;
+	bool has_format = false;
+	bool has_data = false;
+
+	// chunks are word aligned, anything but format and data is skipped
+	while (file->get_position() + 8 <= file->get_length()) {
+		uint32_t id = file->get_32();
+		uint32_t size = file->get_32();
+		uint64_t next = file->get_position() + size + (size & 1);
+
+		if (id == WAV_FMT) {
+			format_tag = file->get_16();
+			channels = file->get_16();
+			sample_rate = file->get_32();
+			file->get_32(); // byte rate
+			file->get_16(); // block align
+			bits_per_sample = file->get_16();
+
+			if (format_tag == WAV_FORMAT_EXTENSIBLE && size >= 40) {
+				file->get_16(); // extension size
+				file->get_16(); // valid bits
+				file->get_32(); // channel mask
+				format_tag = file->get_16(); // first two bytes of the sub format guid
+			}
+			has_format = true;
+		} else if (id == WAV_DATA) {
+			// streamed recordings may leave the size unset, the rest of the file is data then
+			data_size = MIN((uint64_t)size, file->get_length() - file->get_position());
+			data_remaining = data_size;
+			has_data = true;
+			break;
+		}
+
+		file->seek(next);
+	}
+
+	ERR_FAIL_COND_V_MSG(!has_format || !has_data, false, "[WhisperAudioFile] missing format or data chunk: " + p_path);
+
+	bool supported = (format_tag == WAV_FORMAT_PCM && (bits_per_sample == 8 || bits_per_sample == 16 || bits_per_sample == 24 || bits_per_sample == 32)) ||
+			(format_tag == WAV_FORMAT_FLOAT && bits_per_sample == 32);
+	ERR_FAIL_COND_V_MSG(!supported || channels <= 0 || sample_rate <= 0, false, "[WhisperAudioFile] unsupported WAV encoding: " + p_path);
+
+	frame_bytes = channels * bits_per_sample / 8;
+	resampler.setup(sample_rate);
+	return true;
+}
+
+void WhisperAudioFile::close() {
+	file.unref();
+	stream.unref();
+	playback.unref();
+	data_size = 0;
+	data_remaining = 0;
+}
+
+// converts p_frames frames of raw to mono floats, channels are averaged
+void WhisperAudioFile::_decode_pcm(int p_frames) {
+	const uint8_t *src = raw.ptr();
+	const int bytes = bits_per_sample / 8;
+	const float scale = 1.0f / channels;
+
+	mono.resize(p_frames);
+	for (int i = 0; i < p_frames; i++) {
+		float sum = 0.0f;
+		for (int c = 0; c < channels; c++, src += bytes) {
+			if (format_tag == WAV_FORMAT_FLOAT) {
+				float value;
+				memcpy(&value, src, sizeof(float));
+				sum += value;
+			} else if (bytes == 1) {
+				sum += (int(src[0]) - 128) / 128.0f;
+			} else if (bytes == 2) {
+				sum += int16_t(src[0] | (src[1] << 8)) / 32768.0f;
+			} else if (bytes == 3) {
+				// shifted into the top of an int32 to sign extend
+				sum += int32_t((uint32_t(src[0]) << 8) | (uint32_t(src[1]) << 16) | (uint32_t(src[2]) << 24)) / 2147483648.0f;
+			} else {
+				sum += int32_t(uint32_t(src[0]) | (uint32_t(src[1]) << 8) | (uint32_t(src[2]) << 16) | (uint32_t(src[3]) << 24)) / 2147483648.0f;
+			}
+		}
+		mono[i] = sum * scale;
+	}
+}
+
+bool WhisperAudioFile::read(LocalVector<float> &r_samples) {
+	const uint32_t offset = r_samples.size();
+
+	if (file.is_valid()) {
+		int n_frames = int(MIN((uint64_t)CHUNK_FRAMES, data_remaining / frame_bytes));
+		if (n_frames <= 0) {
+			return false;
+		}
+
+		// raw and mono keep their capacity, so reading allocates nothing after the first chunk
+		raw.resize(n_frames * frame_bytes);
+		uint64_t n_read = file->get_buffer(raw.ptr(), raw.size());
+		n_frames = int(n_read / frame_bytes);
+		data_remaining = n_read < raw.size() ? 0 : data_remaining - n_read;
+		if (n_frames <= 0) {
+			return false;
+		}
+
+		_decode_pcm(n_frames);
+		r_samples.resize(offset + resampler.get_max_output(n_frames));
+		int n_output = resampler.process_mono(mono.ptr(), n_frames, r_samples.ptr() + offset);
+		r_samples.resize(offset + n_output);
+		return true;
+	}
+
+	if (playback.is_valid() && playback->is_playing()) {
+		PackedVector2Array frames = playback->mix_audio(1.0f, CHUNK_FRAMES);
+		if (frames.is_empty()) {
+			return false;
+		}
+
+		r_samples.resize(offset + resampler.get_max_output(frames.size()));
+		int n_output = resampler.process_stereo(frames.ptr(), frames.size(), r_samples.ptr() + offset);
+		r_samples.resize(offset + n_output);
+		return true;
+	}
+
+	return false;
+}
+
+float WhisperAudioFile::get_progress() const {
+	if (file.is_valid()) {
+		return data_size > 0 ? float(data_size - data_remaining) / data_size : 1.0f;
+	}
+
+	if (playback.is_valid()) {
+		double length = stream->get_length();
+		return playback->is_playing() && length > 0.0 ? float(MIN(playback->get_playback_position() / length, 1.0)) : 1.0f;
+	}
+
+	return 0.0f;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <godot_cpp/classes/audio_stream.hpp>
+#include <godot_cpp/classes/audio_stream_playback.hpp>
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/variant/string.hpp>
+using namespace godot;
+
+#include "whisper_resampler.h"
+
+// this class decodes an audio file into whisper's 16kHz mono input a chunk at a time.
+// WAV files are read straight from FileAccess, so only one chunk of PCM is ever in memory.
+// OGG Vorbis and MP3 keep their compressed data in memory and are decoded through an AudioStreamPlayback.
+class WhisperAudioFile {
+	static const int CHUNK_FRAMES = 16384;
+
+	// wav
+	Ref<FileAccess> file;
+	int format_tag = 0;
+	int channels = 0;
+	int bits_per_sample = 0;
+	int frame_bytes = 0;
+	uint64_t data_size = 0;
+	uint64_t data_remaining = 0;
+	LocalVector<uint8_t> raw;
+	LocalVector<float> mono;
+
+	// compressed formats
+	Ref<AudioStream> stream;
+	Ref<AudioStreamPlayback> playback;
+
+	WhisperResampler resampler;
+
+	bool _open_wav(const String &p_path);
+	void _decode_pcm(int p_frames);
+
+public:
+	// supports .wav (8/16/24/32-bit PCM, 32-bit float), .ogg and .mp3
+	bool open(const String &p_path);
+	void close();
+
+	// appends the next chunk of resampled audio to r_samples, returns false once the file is exhausted
+	bool read(LocalVector<float> &r_samples);
+
+	// how much of the file has been read, 0 to 1
+	float get_progress() const;
+};
@@ -0,0 +1,609 @@
+#include "whisper_benchmark.h"
+
+#include <godot_cpp/classes/json.hpp>
+#include <godot_cpp/classes/os.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/core/math.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+using namespace godot;
+
+#include "whisper_audio_file.h"
+#include "whisper_microphone_transcriber.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#define WIN32_LEAN_AND_MEAN
+#define PSAPI_VERSION 2 // GetProcessMemoryInfo from kernel32, no psapi.lib
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <sys/resource.h>
+#elif defined(__unix__)
+#include <sys/resource.h>
+#include <unistd.h>
+#include <cstdio>
+#endif
+
+WhisperBenchmark::WhisperBenchmark() {
+	modes.push_back("transcribe");
+	modes.push_back("parallel");
+	modes.push_back("stream");
+	n_threads_values.push_back(4);
+	audio_ctx_values.push_back(0);
+	strategies.push_back(WhisperFull::GREEDY);
+	beam_sizes.push_back(5);
+	step_ms_values.push_back(3000);
+	length_ms_values.push_back(10000);
+}
+
+WhisperBenchmark::~WhisperBenchmark() {
+}
+
+void WhisperBenchmark::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("set_model", "model"), &WhisperBenchmark::set_model);
+	ClassDB::bind_method(D_METHOD("get_model"), &WhisperBenchmark::get_model);
+
+	ClassDB::bind_method(D_METHOD("set_use_gpu", "use_gpu"), &WhisperBenchmark::set_use_gpu);
+	ClassDB::bind_method(D_METHOD("get_use_gpu"), &WhisperBenchmark::get_use_gpu);
+
+	ClassDB::bind_method(D_METHOD("set_language", "language"), &WhisperBenchmark::set_language);
+	ClassDB::bind_method(D_METHOD("get_language"), &WhisperBenchmark::get_language);
+
+	ClassDB::bind_method(D_METHOD("set_audio_path", "audio_path"), &WhisperBenchmark::set_audio_path);
+	ClassDB::bind_method(D_METHOD("get_audio_path"), &WhisperBenchmark::get_audio_path);
+
+	ClassDB::bind_method(D_METHOD("set_synthetic_duration_s", "synthetic_duration_s"), &WhisperBenchmark::set_synthetic_duration_s);
+	ClassDB::bind_method(D_METHOD("get_synthetic_duration_s"), &WhisperBenchmark::get_synthetic_duration_s);
+
+	ClassDB::bind_method(D_METHOD("set_iterations", "iterations"), &WhisperBenchmark::set_iterations);
+	ClassDB::bind_method(D_METHOD("get_iterations"), &WhisperBenchmark::get_iterations);
+
+	ClassDB::bind_method(D_METHOD("set_warmup_iterations", "warmup_iterations"), &WhisperBenchmark::set_warmup_iterations);
+	ClassDB::bind_method(D_METHOD("get_warmup_iterations"), &WhisperBenchmark::get_warmup_iterations);
+
+	ClassDB::bind_method(D_METHOD("set_modes", "modes"), &WhisperBenchmark::set_modes);
+	ClassDB::bind_method(D_METHOD("get_modes"), &WhisperBenchmark::get_modes);
+
+	ClassDB::bind_method(D_METHOD("set_n_threads_values", "values"), &WhisperBenchmark::set_n_threads_values);
+	ClassDB::bind_method(D_METHOD("get_n_threads_values"), &WhisperBenchmark::get_n_threads_values);
+
+	ClassDB::bind_method(D_METHOD("set_audio_ctx_values", "values"), &WhisperBenchmark::set_audio_ctx_values);
+	ClassDB::bind_method(D_METHOD("get_audio_ctx_values"), &WhisperBenchmark::get_audio_ctx_values);
+
+	ClassDB::bind_method(D_METHOD("set_strategies", "values"), &WhisperBenchmark::set_strategies);
+	ClassDB::bind_method(D_METHOD("get_strategies"), &WhisperBenchmark::get_strategies);
+
+	ClassDB::bind_method(D_METHOD("set_beam_sizes", "values"), &WhisperBenchmark::set_beam_sizes);
+	ClassDB::bind_method(D_METHOD("get_beam_sizes"), &WhisperBenchmark::get_beam_sizes);
+
+	ClassDB::bind_method(D_METHOD("set_step_ms_values", "values"), &WhisperBenchmark::set_step_ms_values);
+	ClassDB::bind_method(D_METHOD("get_step_ms_values"), &WhisperBenchmark::get_step_ms_values);
+
+	ClassDB::bind_method(D_METHOD("set_length_ms_values", "values"), &WhisperBenchmark::set_length_ms_values);
+	ClassDB::bind_method(D_METHOD("get_length_ms_values"), &WhisperBenchmark::get_length_ms_values);
+
+	ClassDB::bind_method(D_METHOD("set_keep_ms", "keep_ms"), &WhisperBenchmark::set_keep_ms);
+	ClassDB::bind_method(D_METHOD("get_keep_ms"), &WhisperBenchmark::get_keep_ms);
+
+	ClassDB::bind_method(D_METHOD("set_n_processors", "n_processors"), &WhisperBenchmark::set_n_processors);
+	ClassDB::bind_method(D_METHOD("get_n_processors"), &WhisperBenchmark::get_n_processors);
+
+	ClassDB::bind_method(D_METHOD("run"), &WhisperBenchmark::run);
+	ClassDB::bind_method(D_METHOD("run_json"), &WhisperBenchmark::run_json);
+
+	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "model", PROPERTY_HINT_RESOURCE_TYPE, "WhisperModel"), "set_model", "get_model");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_gpu"), "set_use_gpu", "get_use_gpu");
+	ADD_PROPERTY(PropertyInfo(Variant::STRING, "language"), "set_language", "get_language");
+
+	ADD_GROUP("Input", "");
+	ADD_PROPERTY(PropertyInfo(Variant::STRING, "audio_path", PROPERTY_HINT_FILE, "*.wav,*.ogg,*.mp3"), "set_audio_path", "get_audio_path");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "synthetic_duration_s", PROPERTY_HINT_RANGE, "1,600,1"), "set_synthetic_duration_s", "get_synthetic_duration_s");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "iterations", PROPERTY_HINT_RANGE, "1,100,1"), "set_iterations", "get_iterations");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "warmup_iterations", PROPERTY_HINT_RANGE, "0,10,1"), "set_warmup_iterations", "get_warmup_iterations");
+
+	ADD_GROUP("Sweep", "");
+	ADD_PROPERTY(PropertyInfo(Variant::PACKED_STRING_ARRAY, "modes"), "set_modes", "get_modes");
+	ADD_PROPERTY(PropertyInfo(Variant::PACKED_INT32_ARRAY, "n_threads_values"), "set_n_threads_values", "get_n_threads_values");
+	ADD_PROPERTY(PropertyInfo(Variant::PACKED_INT32_ARRAY, "audio_ctx_values"), "set_audio_ctx_values", "get_audio_ctx_values");
+	ADD_PROPERTY(PropertyInfo(Variant::PACKED_INT32_ARRAY, "strategies"), "set_strategies", "get_strategies");
+	ADD_PROPERTY(PropertyInfo(Variant::PACKED_INT32_ARRAY, "beam_sizes"), "set_beam_sizes", "get_beam_sizes");
+	ADD_PROPERTY(PropertyInfo(Variant::PACKED_INT32_ARRAY, "step_ms_values"), "set_step_ms_values", "get_step_ms_values");
+	ADD_PROPERTY(PropertyInfo(Variant::PACKED_INT32_ARRAY, "length_ms_values"), "set_length_ms_values", "get_length_ms_values");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "keep_ms", PROPERTY_HINT_RANGE, "0,2000,50"), "set_keep_ms", "get_keep_ms");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "n_processors", PROPERTY_HINT_RANGE, "0,32,1"), "set_n_processors", "get_n_processors");
+}
+
+/* --- properties --- */
+
+void WhisperBenchmark::set_model(const Ref<WhisperModel> &p_model) {
+	model = p_model;
+}
+
+Ref<WhisperModel> WhisperBenchmark::get_model() const {
+	return model;
+}
+
+void WhisperBenchmark::set_use_gpu(bool p_use_gpu) {
+	use_gpu = p_use_gpu;
+}
+
+bool WhisperBenchmark::get_use_gpu() const {
+	return use_gpu;
+}
+
+void WhisperBenchmark::set_language(const String &p_language) {
+	language = p_language;
+}
+
+String WhisperBenchmark::get_language() const {
+	return language;
+}
+
+void WhisperBenchmark::set_audio_path(const String &p_audio_path) {
+	audio_path = p_audio_path;
+}
+
+String WhisperBenchmark::get_audio_path() const {
+	return audio_path;
+}
+
+void WhisperBenchmark::set_synthetic_duration_s(float p_synthetic_duration_s) {
+	synthetic_duration_s = CLAMP(p_synthetic_duration_s, 1.0f, 600.0f);
+}
+
+float WhisperBenchmark::get_synthetic_duration_s() const {
+	return synthetic_duration_s;
+}
+
+void WhisperBenchmark::set_iterations(int p_iterations) {
+	iterations = MAX(1, p_iterations);
+}
+
+int WhisperBenchmark::get_iterations() const {
+	return iterations;
+}
+
+void WhisperBenchmark::set_warmup_iterations(int p_warmup_iterations) {
+	warmup_iterations = MAX(0, p_warmup_iterations);
+}
+
+int WhisperBenchmark::get_warmup_iterations() const {
+	return warmup_iterations;
+}
+
+void WhisperBenchmark::set_modes(const PackedStringArray &p_modes) {
+	modes = p_modes;
+}
+
+PackedStringArray WhisperBenchmark::get_modes() const {
+	return modes;
+}
+
+void WhisperBenchmark::set_n_threads_values(const PackedInt32Array &p_values) {
+	n_threads_values = p_values;
+}
+
+PackedInt32Array WhisperBenchmark::get_n_threads_values() const {
+	return n_threads_values;
+}
+
+void WhisperBenchmark::set_audio_ctx_values(const PackedInt32Array &p_values) {
+	audio_ctx_values = p_values;
+}
+
+PackedInt32Array WhisperBenchmark::get_audio_ctx_values() const {
+	return audio_ctx_values;
+}
+
+void WhisperBenchmark::set_strategies(const PackedInt32Array &p_values) {
+	strategies = p_values;
+}
+
+PackedInt32Array WhisperBenchmark::get_strategies() const {
+	return strategies;
+}
+
+void WhisperBenchmark::set_beam_sizes(const PackedInt32Array &p_values) {
+	beam_sizes = p_values;
+}
+
+PackedInt32Array WhisperBenchmark::get_beam_sizes() const {
+	return beam_sizes;
+}
+
+void WhisperBenchmark::set_step_ms_values(const PackedInt32Array &p_values) {
+	step_ms_values = p_values;
+}
+
+PackedInt32Array WhisperBenchmark::get_step_ms_values() const {
+	return step_ms_values;
+}
+
+void WhisperBenchmark::set_length_ms_values(const PackedInt32Array &p_values) {
+	length_ms_values = p_values;
+}
+
+PackedInt32Array WhisperBenchmark::get_length_ms_values() const {
+	return length_ms_values;
+}
+
+void WhisperBenchmark::set_keep_ms(int p_keep_ms) {
+	keep_ms = CLAMP(p_keep_ms, 0, 2000);
+}
+
+int WhisperBenchmark::get_keep_ms() const {
+	return keep_ms;
+}
+
+void WhisperBenchmark::set_n_processors(int p_n_processors) {
+	n_processors = MAX(0, p_n_processors);
+}
+
+int WhisperBenchmark::get_n_processors() const {
+	return n_processors;
+}
+
+/* --- input --- */
+
+bool WhisperBenchmark::_load_audio(LocalVector<float> &r_samples) const {
+	r_samples.clear();
+
+	if (audio_path.is_empty()) {
+		_generate_speech(r_samples, int(synthetic_duration_s * WHISPER_SAMPLE_RATE));
+		return true;
+	}
+
+	WhisperAudioFile file;
+	if (!file.open(audio_path)) {
+		return false;
+	}
+	while (file.read(r_samples)) {
+	}
+	file.close();
+
+	ERR_FAIL_COND_V_MSG(r_samples.is_empty(), false, "[WhisperBenchmark] no audio in file: " + audio_path);
+	return true;
+}
+
+// a voiced buzz with moving formants, in syllables separated by short gaps and phrases separated by pauses,
+// so silence detection and the decoder see something closer to speech than a tone. deterministic for a given length
+void WhisperBenchmark::_generate_speech(LocalVector<float> &r_samples, int p_n_samples) {
+	const int n_harmonics = 24;
+	const double syllable_s = 0.25;
+	const double phrase_s = 4.0;
+
+	r_samples.resize(p_n_samples);
+
+	uint32_t seed = 12345;
+	double phase = 0.0;
+	for (int i = 0; i < p_n_samples; i++) {
+		const double t = double(i) / WHISPER_SAMPLE_RATE;
+
+		seed = seed * 1664525u + 1013904223u;
+		const float noise = (float(seed >> 8) / float(1 << 24) - 0.5f) * 0.004f;
+
+		const double in_phrase = std::fmod(t, phrase_s);
+		const double in_syllable = std::fmod(t, syllable_s);
+		if (in_phrase > phrase_s - 1.0 || in_syllable > syllable_s * 0.8) {
+			r_samples[i] = noise;
+			continue;
+		}
+
+		// pitch with a slow intonation, formants that change every syllable
+		const double f0 = 110.0 + 20.0 * std::sin(Math_TAU * 0.5 * t);
+		const double syllable = std::floor(t / syllable_s);
+		const double f1 = 500.0 + 250.0 * std::sin(syllable * 1.7);
+		const double f2 = 1500.0 + 600.0 * std::cos(syllable * 1.3);
+
+		phase = std::fmod(phase + Math_TAU * f0 / WHISPER_SAMPLE_RATE, Math_TAU);
+
+		double value = 0.0;
+		for (int h = 1; h <= n_harmonics; h++) {
+			const double f = f0 * h;
+			const double a1 = (f - f1) / 120.0;
+			const double a2 = (f - f2) / 180.0;
+			const double gain = std::exp(-a1 * a1) + 0.6 * std::exp(-a2 * a2) + 0.02;
+			value += gain * std::sin(phase * h);
+		}
+
+		// fade each syllable in and out
+		const double envelope = std::sin(Math_PI * in_syllable / (syllable_s * 0.8));
+		r_samples[i] = float(value * envelope * 0.1) + noise;
+	}
+}
+
+/* --- measurement --- */
+
+// peak resident set size of the whole process in bytes, -1 where unknown
+int64_t WhisperBenchmark::_get_peak_rss() {
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return int64_t(counters.PeakWorkingSetSize);
+	}
+	return -1;
+#elif defined(__EMSCRIPTEN__)
+	return -1;
+#elif defined(__APPLE__)
+	struct rusage usage;
+	return getrusage(RUSAGE_SELF, &usage) == 0 ? int64_t(usage.ru_maxrss) : -1; // bytes
+#elif defined(__unix__)
+	struct rusage usage;
+	return getrusage(RUSAGE_SELF, &usage) == 0 ? int64_t(usage.ru_maxrss) * 1024 : -1; // kilobytes
+#else
+	return -1;
+#endif
+}
+
+// resident set size of the whole process right now in bytes, -1 where unknown
+int64_t WhisperBenchmark::_get_current_rss() {
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return int64_t(counters.WorkingSetSize);
+	}
+	return -1;
+#elif defined(__APPLE__)
+	mach_task_basic_info_data_t info;
+	mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+	if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) == KERN_SUCCESS) {
+		return int64_t(info.resident_size);
+	}
+	return -1;
+#elif defined(__linux__)
+	// the second field of statm is the resident size in pages
+	FILE *file = fopen("/proc/self/statm", "r");
+	if (file == nullptr) {
+		return -1;
+	}
+	long size = 0;
+	long resident = 0;
+	int n_read = fscanf(file, "%ld %ld", &size, &resident);
+	fclose(file);
+	return n_read == 2 ? int64_t(resident) * sysconf(_SC_PAGESIZE) : -1;
+#else
+	return -1;
+#endif
+}
+
+static double _to_mb(int64_t p_bytes) {
+	return p_bytes < 0 ? -1.0 : p_bytes / (1024.0 * 1024.0);
+}
+
+static Dictionary _latency_dictionary(const WhisperHistogram &p_histogram) {
+	Dictionary latency;
+	latency["count"] = (int64_t)p_histogram.get_count();
+	latency["mean"] = p_histogram.get_mean() / 1000.0;
+	latency["p50"] = p_histogram.get_percentile(0.50) / 1000.0;
+	latency["p95"] = p_histogram.get_percentile(0.95) / 1000.0;
+	latency["p99"] = p_histogram.get_percentile(0.99) / 1000.0;
+	latency["max"] = p_histogram.get_max() / 1000.0;
+	return latency;
+}
+
+// steps the transcriber's worker has transcribed so far
+static int64_t _get_transcribed_steps(WhisperMicrophoneTranscriber *p_transcriber) {
+	Dictionary stage = p_transcriber->get_metrics().get("transcribe", Dictionary());
+	return stage.get("count", 0);
+}
+
+// one pass over the audio, returns the summed processing time in microseconds or -1 on failure
+int64_t WhisperBenchmark::_run_once(const Ref<WhisperFull> &p_whisper, const String &p_mode, const LocalVector<float> &p_samples, const PackedFloat32Array &p_packed, WhisperMicrophoneTranscriber *p_transcriber, WhisperHistogram *r_latency) {
+	Time *time = Time::get_singleton();
+
+	if (p_mode == "stream") {
+		// the transcriber's own path (ring, mel cache, step scheduling) with push_audio_chunk as the microphone.
+		// the next step is pushed as soon as the previous one is transcribed, so this measures how fast
+		// the transcriber can go instead of waiting out the audio in real time
+		const int n_samples_step = p_transcriber->get_step_ms() * WHISPER_SAMPLE_RATE / 1000;
+		const uint64_t step_timeout_usec = 120 * 1000000;
+
+		ERR_FAIL_COND_V_MSG(!p_transcriber->start(), -1, "[WhisperBenchmark] failed to start the transcriber");
+
+		PackedFloat32Array chunk;
+		chunk.resize(n_samples_step);
+
+		uint64_t total_usec = 0;
+		bool timed_out = false;
+		for (int start = 0; start + n_samples_step <= (int)p_samples.size() && !timed_out; start += n_samples_step) {
+			memcpy(chunk.ptrw(), p_samples.ptr() + start, n_samples_step * sizeof(float));
+			const int64_t n_transcribed = _get_transcribed_steps(p_transcriber);
+
+			uint64_t t_start = time->get_ticks_usec();
+			p_transcriber->push_audio_chunk(chunk);
+			while (_get_transcribed_steps(p_transcriber) == n_transcribed) {
+				if (time->get_ticks_usec() - t_start > step_timeout_usec) {
+					timed_out = true;
+					break;
+				}
+				OS::get_singleton()->delay_usec(200);
+			}
+			uint64_t step_usec = time->get_ticks_usec() - t_start;
+
+			total_usec += step_usec;
+			if (r_latency) {
+				r_latency->record(step_usec);
+			}
+		}
+
+		p_transcriber->stop();
+		ERR_FAIL_COND_V_MSG(timed_out, -1, "[WhisperBenchmark] stream step timed out");
+		return int64_t(total_usec);
+	}
+
+	uint64_t t_start = time->get_ticks_usec();
+	int result = p_mode == "parallel" ? p_whisper->transcribe_parallel(p_packed, n_processors) : p_whisper->transcribe(p_packed);
+	uint64_t usec = time->get_ticks_usec() - t_start;
+	ERR_FAIL_COND_V_MSG(result != 0, -1, "[WhisperBenchmark] " + p_mode + " failed");
+
+	if (r_latency) {
+		r_latency->record(usec);
+	}
+	return int64_t(usec);
+}
+
+Dictionary WhisperBenchmark::_run_config(const Ref<WhisperFull> &p_whisper, const String &p_mode, const LocalVector<float> &p_samples, int p_step_ms, int p_length_ms) {
+	PackedFloat32Array packed;
+	if (p_mode != "stream") {
+		packed.resize(p_samples.size());
+		memcpy(packed.ptrw(), p_samples.ptr(), p_samples.size() * sizeof(float));
+	}
+
+	// streaming goes through a transcriber that owns the windowing, fed without a microphone
+	WhisperMicrophoneTranscriber *transcriber = nullptr;
+	if (p_mode == "stream") {
+		transcriber = memnew(WhisperMicrophoneTranscriber);
+		transcriber->set_whisper(p_whisper);
+		transcriber->set_use_microphone(false);
+		transcriber->set_step_ms(p_step_ms);
+		transcriber->set_length_ms(p_length_ms);
+		transcriber->set_keep_ms(keep_ms);
+	}
+
+	Dictionary result;
+	result["mode"] = p_mode;
+	result["n_threads"] = p_whisper->get_n_threads();
+	result["audio_ctx"] = p_whisper->get_audio_ctx();
+	result["strategy"] = p_whisper->get_strategy() == WhisperFull::BEAM_SEARCH ? "beam_search" : "greedy";
+	result["beam_size"] = p_whisper->get_strategy() == WhisperFull::BEAM_SEARCH ? p_whisper->get_beam_size() : 1;
+	if (transcriber) {
+		result["step_ms"] = transcriber->get_step_ms();
+		result["length_ms"] = transcriber->get_length_ms();
+		result["keep_ms"] = transcriber->get_keep_ms();
+	}
+
+	// the process-wide peak never goes down, each run reports what it left resident instead
+	const int64_t rss_before = _get_current_rss();
+
+	bool failed = false;
+	for (int i = 0; i < warmup_iterations && !failed; i++) {
+		failed = _run_once(p_whisper, p_mode, p_samples, packed, transcriber, nullptr) < 0;
+	}
+
+	// the stage metrics only cover the measured iterations
+	p_whisper->reset_metrics();
+	if (transcriber) {
+		transcriber->reset_metrics();
+	}
+
+	WhisperHistogram latency;
+	uint64_t total_usec = 0;
+	for (int i = 0; i < iterations && !failed; i++) {
+		int64_t usec = _run_once(p_whisper, p_mode, p_samples, packed, transcriber, &latency);
+		failed = usec < 0;
+		total_usec += MAX(usec, (int64_t)0);
+	}
+
+	if (transcriber) {
+		// ring, lock, mel and step stages of the transcriber's worker
+		result["transcriber_stages"] = transcriber->get_metrics();
+		memdelete(transcriber);
+	}
+
+	if (failed) {
+		result["error"] = "failed";
+		return result;
+	}
+
+	const double audio_s = double(p_samples.size()) / WHISPER_SAMPLE_RATE;
+	result["rtf"] = total_usec / 1000000.0 / (audio_s * iterations);
+	result["latency_ms"] = _latency_dictionary(latency);
+	result["stages"] = p_whisper->get_metrics();
+	result["segments"] = p_whisper->get_segment_count();
+	const int64_t rss_after = _get_current_rss();
+	result["rss_mb"] = _to_mb(rss_after);
+	result["rss_delta_mb"] = rss_before < 0 || rss_after < 0 ? 0.0 : (rss_after - rss_before) / (1024.0 * 1024.0);
+
+	UtilityFunctions::print("[WhisperBenchmark] ", p_mode, " threads=", result["n_threads"], " audio_ctx=", result["audio_ctx"], " ", result["strategy"], " beam=", result["beam_size"],
+			p_mode == "stream" ? String(" step=") + itos((int64_t)result["step_ms"]) + " length=" + itos((int64_t)result["length_ms"]) : String(), " rtf=", String::num(result["rtf"], 3));
+	return result;
+}
+
+/* --- run --- */
+
+Dictionary WhisperBenchmark::run() {
+	Dictionary report;
+	ERR_FAIL_COND_V_MSG(model.is_null(), report, "[WhisperBenchmark] no model set");
+
+	LocalVector<float> samples;
+	ERR_FAIL_COND_V_MSG(!_load_audio(samples), report, "[WhisperBenchmark] failed to load audio");
+
+	Ref<WhisperFull> whisper;
+	whisper.instantiate();
+	whisper->set_model(model);
+	whisper->set_use_gpu(use_gpu);
+	whisper->set_language(language);
+	whisper->set_print_timestamps(false);
+
+	ERR_FAIL_COND_V_MSG(!whisper->init(), report, "[WhisperBenchmark] failed to initialize whisper");
+
+	report["system"] = WhisperFull::get_system_info();
+	report["version"] = WhisperFull::get_version();
+	report["model"] = model->get_bin_path();
+	report["use_gpu"] = use_gpu;
+	report["audio"] = audio_path.is_empty() ? String("synthetic") : audio_path;
+	report["audio_s"] = double(samples.size()) / WHISPER_SAMPLE_RATE;
+	report["iterations"] = iterations;
+	report["init_peak_rss_mb"] = _to_mb(_get_peak_rss()); // the model is loaded by now
+	report["init_rss_mb"] = _to_mb(_get_current_rss());
+
+	Array runs;
+	for (int m = 0; m < modes.size(); m++) {
+		const String mode = modes[m];
+		if (mode != "transcribe" && mode != "parallel" && mode != "stream") {
+			ERR_PRINT("[WhisperBenchmark] unknown mode: " + mode);
+			continue;
+		}
+
+		// step and length only matter when streaming
+		const bool stream = mode == "stream";
+		const int n_steps = stream ? step_ms_values.size() : 1;
+		const int n_lengths = stream ? length_ms_values.size() : 1;
+
+		for (int t = 0; t < n_threads_values.size(); t++) {
+			for (int a = 0; a < audio_ctx_values.size(); a++) {
+				for (int s = 0; s < strategies.size(); s++) {
+					const bool beam_search = strategies[s] == WhisperFull::BEAM_SEARCH;
+					const int n_beams = beam_search ? beam_sizes.size() : 1;
+
+					for (int b = 0; b < n_beams; b++) {
+						for (int st = 0; st < n_steps; st++) {
+							for (int l = 0; l < n_lengths; l++) {
+								whisper->set_n_threads(n_threads_values[t]);
+								whisper->set_audio_ctx(audio_ctx_values[a]);
+								whisper->set_strategy(beam_search ? WhisperFull::BEAM_SEARCH : WhisperFull::GREEDY);
+								if (beam_search) {
+									whisper->set_beam_size(beam_sizes[b]);
+								}
+
+								// streaming decodes each window on its own, like the transcriber
+								whisper->set_no_context(stream);
+								whisper->set_single_segment(stream);
+
+								runs.push_back(_run_config(whisper, mode, samples, stream ? step_ms_values[st] : 0, stream ? length_ms_values[l] : 0));
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	report["runs"] = runs;
+	report["peak_rss_mb"] = _to_mb(_get_peak_rss());
+
+	whisper->free_context();
+	return report;
+}
+
+String WhisperBenchmark::run_json() {
+	return JSON::stringify(run(), "\t", false);
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/packed_int32_array.hpp>
+#include <godot_cpp/variant/packed_string_array.hpp>
+using namespace godot;
+
+#include "whisper_full.h"
+#include "whisper_metrics.h"
+#include "whisper_model.h"
+
+class WhisperMicrophoneTranscriber;
+
+// this class sweeps WhisperFull settings over the same audio and reports throughput and latency.
+// every combination of n_threads, audio_ctx, strategy and beam size (and step/length for "stream")
+// is run for each mode: "transcribe" (one whisper_full over the audio), "parallel" (transcribe_parallel)
+// and "stream" (a WhisperMicrophoneTranscriber fed through push_audio_chunk instead of a microphone).
+// it is driven headlessly by benchmark/benchmark.gd, see the "benchmark" target in SConstruct
+class WhisperBenchmark : public RefCounted {
+	GDCLASS(WhisperBenchmark, RefCounted);
+
+	Ref<WhisperModel> model;
+	bool use_gpu = false;
+	String language = "en";
+
+	// input, synthetic speech-like audio when no file is set
+	String audio_path;
+	float synthetic_duration_s = 30.0f;
+
+	int iterations = 3;
+	int warmup_iterations = 1;
+
+	// sweep
+	PackedStringArray modes;
+	PackedInt32Array n_threads_values;
+	PackedInt32Array audio_ctx_values;
+	PackedInt32Array strategies;
+	PackedInt32Array beam_sizes;
+	PackedInt32Array step_ms_values;
+	PackedInt32Array length_ms_values;
+	int keep_ms = 200;
+	int n_processors = 0;
+
+	bool _load_audio(LocalVector<float> &r_samples) const;
+	static void _generate_speech(LocalVector<float> &r_samples, int p_n_samples);
+	static int64_t _get_peak_rss();
+	static int64_t _get_current_rss();
+
+	Dictionary _run_config(const Ref<WhisperFull> &p_whisper, const String &p_mode, const LocalVector<float> &p_samples, int p_step_ms, int p_length_ms);
+	int64_t _run_once(const Ref<WhisperFull> &p_whisper, const String &p_mode, const LocalVector<float> &p_samples, const PackedFloat32Array &p_packed, WhisperMicrophoneTranscriber *p_transcriber, WhisperHistogram *r_latency);
+
+protected:
+	static void _bind_methods();
+
+public:
+	void set_model(const Ref<WhisperModel> &p_model);
+	Ref<WhisperModel> get_model() const;
+
+	void set_use_gpu(bool p_use_gpu);
+	bool get_use_gpu() const;
+
+	void set_language(const String &p_language);
+	String get_language() const;
+
+	void set_audio_path(const String &p_audio_path);
+	String get_audio_path() const;
+
+	void set_synthetic_duration_s(float p_synthetic_duration_s);
+	float get_synthetic_duration_s() const;
+
+	void set_iterations(int p_iterations);
+	int get_iterations() const;
+
+	void set_warmup_iterations(int p_warmup_iterations);
+	int get_warmup_iterations() const;
+
+	void set_modes(const PackedStringArray &p_modes);
+	PackedStringArray get_modes() const;
+
+	void set_n_threads_values(const PackedInt32Array &p_values);
+	PackedInt32Array get_n_threads_values() const;
+
+	void set_audio_ctx_values(const PackedInt32Array &p_values);
+	PackedInt32Array get_audio_ctx_values() const;
+
+	void set_strategies(const PackedInt32Array &p_values);
+	PackedInt32Array get_strategies() const;
+
+	void set_beam_sizes(const PackedInt32Array &p_values);
+	PackedInt32Array get_beam_sizes() const;
+
+	void set_step_ms_values(const PackedInt32Array &p_values);
+	PackedInt32Array get_step_ms_values() const;
+
+	void set_length_ms_values(const PackedInt32Array &p_values);
+	PackedInt32Array get_length_ms_values() const;
+
+	void set_keep_ms(int p_keep_ms);
+	int get_keep_ms() const;
+
+	void set_n_processors(int p_n_processors);
+	int get_n_processors() const;
+
+	// runs the whole sweep on the calling thread:
+	// { system, version, audio_s, init_rss_mb, init_peak_rss_mb, peak_rss_mb,
+	//   runs: [{ mode, settings..., rtf, latency_ms: { mean, p50, p95, p99, max }, stages, transcriber_stages (stream), rss_mb, rss_delta_mb }] }
+	// peak_rss_mb is the process-wide peak over the whole sweep, rss_mb is the resident size after a run
+	// and rss_delta_mb how much the run changed it
+	Dictionary run();
+	String run_json();
+
+	WhisperBenchmark();
+	~WhisperBenchmark();
+};
@@ -0,0 +1,113 @@
+#include "whisper_context_cache.h"
+
+#include <godot_cpp/classes/project_settings.hpp>
+#include <godot_cpp/core/memory.hpp>
+using namespace godot;
+
+WhisperContextCache *WhisperContextCache::singleton = nullptr;
+
+WhisperContextCache *WhisperContextCache::get_singleton() {
+	return singleton;
+}
+
+WhisperContextCache::WhisperContextCache() {
+	mtx.instantiate();
+	singleton = this;
+}
+
+WhisperContextCache::~WhisperContextCache() {
+	// entries are erased when their last user releases them, so anything left here is still
+	// in use by a WhisperFull that outlived the library. its context is leaked rather than
+	// freed under it
+	if (!entries.is_empty()) {
+		WARN_PRINT("[WhisperContextCache] " + String::num_int64(entries.size()) + " model context(s) still in use at exit, they are not freed");
+	}
+	for (KeyValue<String, Entry *> &E : entries) {
+		memdelete(E.value);
+	}
+	entries.clear();
+
+	if (singleton == this) {
+		singleton = nullptr;
+	}
+}
+
+String WhisperContextCache::_make_key(const String &p_path, const whisper_context_params &p_params) {
+	String path = ProjectSettings::get_singleton()->globalize_path(p_path);
+	return path + "|gpu=" + String::num_int64(p_params.use_gpu) + "|flash_attn=" + String::num_int64(p_params.flash_attn) + "|gpu_device=" + String::num_int64(p_params.gpu_device);
+}
+
+void WhisperContextCache::_unref_entry(Entry *p_entry) {
+	// must be called with mtx locked
+	p_entry->refcount--;
+	if (p_entry->refcount > 0) {
+		return;
+	}
+
+	entries.erase(p_entry->key);
+	if (p_entry->ctx != nullptr) {
+		whisper_free(p_entry->ctx);
+	}
+	memdelete(p_entry);
+}
+
+whisper_context *WhisperContextCache::acquire(const String &p_path, const whisper_context_params &p_params, WhisperLoadProgress *p_progress) {
+	String key = _make_key(p_path, p_params);
+
+	Entry *entry = nullptr;
+	{
+		mtx->lock();
+
+		HashMap<String, Entry *>::Iterator E = entries.find(key);
+		if (E) {
+			entry = E->value;
+		} else {
+			entry = memnew(Entry);
+			entry->key = key;
+			entry->load_mtx.instantiate();
+			entries.insert(key, entry);
+		}
+		entry->refcount++;
+
+		mtx->unlock();
+	}
+
+	// loading happens outside the cache lock, so other models can load concurrently.
+	// users of the same model wait here for the first one to finish
+	entry->load_mtx->lock();
+	if (entry->ctx == nullptr) {
+		entry->ctx = WhisperModelLoader::init_context(p_path, p_params, p_progress);
+	}
+	whisper_context *ctx = entry->ctx;
+	entry->load_mtx->unlock();
+
+	if (ctx == nullptr) {
+		mtx->lock();
+		_unref_entry(entry);
+		mtx->unlock();
+	}
+
+	return ctx;
+}
+
+void WhisperContextCache::release(whisper_context *p_ctx) {
+	if (p_ctx == nullptr) {
+		return;
+	}
+
+	mtx->lock();
+	for (KeyValue<String, Entry *> &E : entries) {
+		if (E.value->ctx == p_ctx) {
+			_unref_entry(E.value);
+			break;
+		}
+	}
+	mtx->unlock();
+}
+
+int WhisperContextCache::get_context_count() const {
+	mtx->lock();
+	int count = entries.size();
+	mtx->unlock();
+	return count;
+}
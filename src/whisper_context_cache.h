@@ -0,0 +1,45 @@
+#pragma once
+
+#include <godot_cpp/classes/mutex.hpp>
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/variant/string.hpp>
+using namespace godot;
+
+#include <whisper.h>
+
+#include "whisper_model_loader.h"
+
+// this class shares loaded model weights between WhisperFull instances.
+// contexts are created without a state (each user owns its own whisper_state)
+// and are keyed by model path plus the context parameters that affect the weights.
+// a context is freed when its last user releases it.
+class WhisperContextCache {
+	struct Entry {
+		String key;
+		whisper_context *ctx = nullptr;
+		int refcount = 0;
+		Ref<Mutex> load_mtx; // held while the weights are loading
+	};
+
+	static WhisperContextCache *singleton;
+
+	Ref<Mutex> mtx;
+	HashMap<String, Entry *> entries;
+
+	static String _make_key(const String &p_path, const whisper_context_params &p_params);
+	void _unref_entry(Entry *p_entry);
+
+public:
+	static WhisperContextCache *get_singleton();
+
+	// returns a shared context, loading the model if no other user holds it.
+	// progress is only reported if this call ends up loading the weights.
+	// every successful acquire must be paired with a release
+	whisper_context *acquire(const String &p_path, const whisper_context_params &p_params, WhisperLoadProgress *p_progress = nullptr);
+	void release(whisper_context *p_ctx);
+
+	int get_context_count() const;
+
+	WhisperContextCache();
+	~WhisperContextCache();
+};
@@ -2,11 +2,20 @@
 
 #include <godot_cpp/core/class_db.hpp>
 #include <godot_cpp/variant/utility_functions.hpp>
-#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/classes/os.hpp>
+#include <godot_cpp/classes/worker_thread_pool.hpp>
 using namespace godot;
 
 #include <whisper.h>
 
+#include <cstring>
+
+#include "whisper_audio_file.h"
+#include "whisper_context_cache.h"
+#include "whisper_resampler.h"
+#include "whisper_voice_detector.h"
+
 /* --- WhisperSegment implementation --- */
 
 WhisperSegment::WhisperSegment() {
@@ -38,20 +47,166 @@ void WhisperSegment::_bind_methods() {
 	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "no_speech_prob"), "set_no_speech_prob", "get_no_speech_prob");
 }
 
+/* --- WhisperJob implementation --- */
+
+WhisperJob::WhisperJob() {
+	done_sem.instantiate();
+}
+
+WhisperJob::~WhisperJob() {
+}
+
+void WhisperJob::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("get_status"), &WhisperJob::get_status);
+	ClassDB::bind_method(D_METHOD("is_done"), &WhisperJob::is_done);
+	ClassDB::bind_method(D_METHOD("wait"), &WhisperJob::wait);
+	ClassDB::bind_method(D_METHOD("cancel"), &WhisperJob::cancel);
+
+	ClassDB::bind_method(D_METHOD("get_result"), &WhisperJob::get_result);
+	ClassDB::bind_method(D_METHOD("get_segments"), &WhisperJob::get_segments);
+	ClassDB::bind_method(D_METHOD("get_text"), &WhisperJob::get_text);
+
+	ClassDB::bind_method(D_METHOD("get_queue_ms"), &WhisperJob::get_queue_ms);
+	ClassDB::bind_method(D_METHOD("get_process_ms"), &WhisperJob::get_process_ms);
+	ClassDB::bind_method(D_METHOD("get_audio_ctx"), &WhisperJob::get_audio_ctx);
+
+	ADD_SIGNAL(MethodInfo("completed"));
+	ADD_SIGNAL(MethodInfo("segment_ready", PropertyInfo(Variant::OBJECT, "segment", PROPERTY_HINT_RESOURCE_TYPE, "WhisperSegment")));
+	ADD_SIGNAL(MethodInfo("progress", PropertyInfo(Variant::INT, "progress")));
+
+	BIND_ENUM_CONSTANT(STATUS_PENDING);
+	BIND_ENUM_CONSTANT(STATUS_RUNNING);
+	BIND_ENUM_CONSTANT(STATUS_COMPLETED);
+	BIND_ENUM_CONSTANT(STATUS_FAILED);
+	BIND_ENUM_CONSTANT(STATUS_CANCELED);
+}
+
+void WhisperJob::_finish(Status p_status) {
+	status.set(p_status);
+	done_sem->post();
+}
+
+WhisperJob::Status WhisperJob::get_status() const {
+	return (Status)status.get();
+}
+
+bool WhisperJob::is_done() const {
+	return status.get() >= STATUS_COMPLETED;
+}
+
+// blocks until the job is done
+void WhisperJob::wait() {
+	if (is_done()) {
+		return;
+	}
+	done_sem->wait();
+	done_sem->post(); // let other waiters through
+}
+
+void WhisperJob::cancel() {
+	if (is_done()) {
+		return;
+	}
+	cancel_requested.set();
+}
+
+int WhisperJob::get_result() const {
+	return result;
+}
+
+TypedArray<WhisperSegment> WhisperJob::get_segments() const {
+	return segments;
+}
+
+String WhisperJob::get_text() const {
+	return text;
+}
+
+float WhisperJob::get_queue_ms() const {
+	return queue_ms;
+}
+
+float WhisperJob::get_process_ms() const {
+	return process_ms;
+}
+
+int WhisperJob::get_audio_ctx() const {
+	return audio_ctx;
+}
+
 /* --- WhisperFull implementation --- */
 
 WhisperFull::WhisperFull() {
+	init_mtx.instantiate();
+	job_mtx.instantiate();
+	job_sem.instantiate();
+
+	init_progress.callback = _on_load_progress;
+	init_progress.userdata = this;
+	init_progress.cancel = &load_canceled;
+
+	// in MetricStage order
+	metrics.add_stage("queue");
+	metrics.add_stage("mel");
+	metrics.add_stage("encode");
+	metrics.add_stage("decode");
+	metrics.add_stage("total");
+	metrics.add_stage("rtf");
 }
 
 WhisperFull::~WhisperFull() {
+	metrics.remove_monitors();
+
+	// don't wait out loads and transcriptions nobody will use
+	load_canceled.set();
+	cancel();
+	_stop_workers();
+
+	// jobs that never started are canceled. every job still waiting for its signals gets "completed",
+	// so awaiters are released, but "job_completed" isn't emitted from an instance being freed
+	job_mtx->lock();
+	for (List<Ref<WhisperJob>>::Element *E = job_queue.front(); E; E = E->next()) {
+		E->get()->result = -1;
+		E->get()->_finish(WhisperJob::STATUS_CANCELED);
+		finished_jobs.push_back(E->get());
+	}
+	job_queue.clear();
+	List<Ref<WhisperJob>> jobs = finished_jobs;
+	finished_jobs.clear();
+	job_mtx->unlock();
+
+	for (List<Ref<WhisperJob>>::Element *E = jobs.front(); E; E = E->next()) {
+		E->get()->emit_signal("completed");
+	}
+
 	_free_context();
 }
 
 bool WhisperFull::_init_context() {
-	if (ctx != nullptr) {
+	if (initialized.is_set()) {
 		return true; // already initialized
 	}
 
+	// serialized with init_async, a second caller waits for the load in progress
+	WhisperLoadProgress progress;
+	progress.cancel = &load_canceled;
+
+	init_mtx->lock();
+	bool result = _load_context(&progress);
+	init_mtx->unlock();
+
+	return result;
+}
+
+bool WhisperFull::_load_context(WhisperLoadProgress *p_progress) {
+	if (ctx != nullptr) {
+		return true;
+	}
+
+	if (load_canceled.is_set()) {
+		return false; // the context is being freed
+	}
+
 	if (model.is_null() || model->get_bin_path().is_empty()) {
 		ERR_PRINT("[WhisperFull] model is not set or has empty path");
 		return false;
@@ -62,27 +217,121 @@ bool WhisperFull::_init_context() {
 	cparams.flash_attn = flash_attn;
 	cparams.gpu_device = gpu_device;
 
-	CharString path_cs = model->get_bin_path().utf8();
-	PackedByteArray content = FileAccess::get_file_as_bytes(model->get_bin_path());
-	ctx = whisper_init_from_buffer_with_params((void *)(content.ptr()), content.size(), cparams);
-
+	// weights are shared with other instances using the same model and context parameters
+	ctx = WhisperContextCache::get_singleton()->acquire(model->get_bin_path(), cparams, p_progress);
 
 	if (ctx == nullptr) {
-		ERR_PRINT("[WhisperFull] failed to initialize whisper context from model: " + model->get_bin_path());
+		if (!load_canceled.is_set()) {
+			ERR_PRINT("[WhisperFull] failed to initialize whisper context from model: " + model->get_bin_path());
+		}
+		return false;
+	}
+
+	state = whisper_init_state(ctx);
+	if (state == nullptr) {
+		ERR_PRINT("[WhisperFull] failed to initialize whisper state for model: " + model->get_bin_path());
+		WhisperContextCache::get_singleton()->release(ctx);
+		ctx = nullptr;
 		return false;
 	}
 
+	initialized.set();
 	return true;
 }
 
 void WhisperFull::_free_context() {
-	if (ctx != nullptr) {
-		whisper_free(ctx);
-		ctx = nullptr;
+	// loads in progress give up at their next read instead of being waited out
+	load_canceled.set();
+	_cancel_init_async();
+
+	// worker states belong to the context being freed
+	_stop_workers();
+
+	init_mtx->lock();
+	initialized.clear();
+
+	result_chunks.clear();
+	result_segment_count = 0;
+
+	for (whisper_state *parallel_state : parallel_states) {
+		whisper_free_state(parallel_state);
+	}
+	parallel_states.clear();
+
+	for (whisper_state *batch_state : batch_states) {
+		whisper_free_state(batch_state);
+	}
+	batch_states.clear();
+
+	if (state != nullptr) {
+		whisper_free_state(state);
+		state = nullptr;
+	}
+
+	// the cache is gone once the library is uninitialized, contexts still in use then are leaked
+	if (ctx != nullptr && WhisperContextCache::get_singleton()) {
+		WhisperContextCache::get_singleton()->release(ctx);
+	}
+	ctx = nullptr;
+
+	init_mtx->unlock();
+
+	load_canceled.clear();
+}
+
+// must be called with load_canceled set, the thread returns as soon as its load gives up
+void WhisperFull::_cancel_init_async() {
+	if (init_thread.is_null()) {
+		return;
+	}
+
+	init_thread->wait_to_finish();
+	init_thread.unref();
+
+	// the thread's own result is dropped
+	init_id++;
+	call_deferred("emit_signal", "init_failed", String("loading was canceled"));
+}
+
+void WhisperFull::_init_thread_func(int p_init_id) {
+	init_mtx->lock();
+	bool result = _load_context(&init_progress);
+	init_mtx->unlock();
+
+	call_deferred("_finish_init_async", result, p_init_id);
+}
+
+void WhisperFull::_finish_init_async(bool p_success, int p_init_id) {
+	if (p_init_id != init_id) {
+		return; // canceled by _free_context
+	}
+
+	if (init_thread.is_valid() && init_thread->is_started()) {
+		init_thread->wait_to_finish();
+	}
+	init_thread.unref();
+
+	if (p_success) {
+		emit_signal("initialized");
+	} else {
+		emit_signal("init_failed", String("failed to initialize whisper context from model"));
+	}
+}
+
+// called from the loading thread for every chunk read, signals are throttled to whole percents
+void WhisperFull::_on_load_progress(void *p_userdata, uint64_t p_bytes_loaded, uint64_t p_bytes_total) {
+	WhisperFull *self = (WhisperFull *)p_userdata;
+
+	int percent = p_bytes_total > 0 ? int(p_bytes_loaded * 100 / p_bytes_total) : 0;
+	if (percent == self->init_progress_percent) {
+		return;
 	}
+	self->init_progress_percent = percent;
+
+	self->call_deferred("emit_signal", "init_progress", (int64_t)p_bytes_loaded, (int64_t)p_bytes_total);
 }
 
-whisper_full_params WhisperFull::_build_params() {
+whisper_full_params WhisperFull::_build_params(WhisperParamStrings &r_strings) {
 	whisper_full_params wparams = whisper_full_default_params(strategy);
 
 	wparams.n_threads = n_threads;
@@ -111,17 +360,17 @@ whisper_full_params WhisperFull::_build_params() {
 	wparams.tdrz_enable = tdrz_enable;
 
 	// store CharString to keep memory valid
-	suppress_regex_cs = suppress_regex.utf8();
-	wparams.suppress_regex = suppress_regex.is_empty() ? nullptr : suppress_regex_cs.get_data();
+	r_strings.suppress_regex = suppress_regex.utf8();
+	wparams.suppress_regex = suppress_regex.is_empty() ? nullptr : r_strings.suppress_regex.get_data();
 
-	initial_prompt_cs = initial_prompt.utf8();
-	wparams.initial_prompt = initial_prompt.is_empty() ? nullptr : initial_prompt_cs.get_data();
+	r_strings.initial_prompt = initial_prompt.utf8();
+	wparams.initial_prompt = initial_prompt.is_empty() ? nullptr : r_strings.initial_prompt.get_data();
 	wparams.carry_initial_prompt = carry_initial_prompt;
 	wparams.prompt_tokens = nullptr;
 	wparams.prompt_n_tokens = 0;
 
-	language_cs = language.utf8();
-	wparams.language = language.is_empty() || language == "auto" ? nullptr : language_cs.get_data();
+	r_strings.language = language.utf8();
+	wparams.language = language.is_empty() || language == "auto" ? nullptr : r_strings.language.get_data();
 	wparams.detect_language = detect_language;
 
 	wparams.suppress_blank = suppress_blank;
@@ -143,8 +392,8 @@ whisper_full_params WhisperFull::_build_params() {
 
 	// vad params
 	wparams.vad = vad_enable;
-	vad_model_path_cs = vad_model_path.utf8();
-	wparams.vad_model_path = vad_model_path.is_empty() ? nullptr : vad_model_path_cs.get_data();
+	r_strings.vad_model_path = vad_model_path.utf8();
+	wparams.vad_model_path = vad_model_path.is_empty() ? nullptr : r_strings.vad_model_path.get_data();
 	wparams.vad_params.threshold = vad_threshold;
 	wparams.vad_params.min_speech_duration_ms = vad_min_speech_duration_ms;
 	wparams.vad_params.min_silence_duration_ms = vad_min_silence_duration_ms;
@@ -152,7 +401,7 @@ whisper_full_params WhisperFull::_build_params() {
 	wparams.vad_params.speech_pad_ms = vad_speech_pad_ms;
 	wparams.vad_params.samples_overlap = vad_samples_overlap;
 
-	// callbacks (not exposed to GDScript for now)
+	// callbacks (installed per call, see _set_callbacks)
 	wparams.new_segment_callback = nullptr;
 	wparams.new_segment_callback_user_data = nullptr;
 	wparams.progress_callback = nullptr;
@@ -173,6 +422,576 @@ whisper_full_params WhisperFull::_build_params() {
 	return wparams;
 }
 
+Ref<WhisperSegment> WhisperFull::_make_segment(whisper_state *p_state, int p_index, int64_t p_t_offset) const {
+	Ref<WhisperSegment> segment;
+	segment.instantiate();
+
+	// times are in centiseconds (1/100 sec), convert to milliseconds
+	segment->set_t0((whisper_full_get_segment_t0_from_state(p_state, p_index) + p_t_offset) * 10);
+	segment->set_t1((whisper_full_get_segment_t1_from_state(p_state, p_index) + p_t_offset) * 10);
+
+	const char *text = whisper_full_get_segment_text_from_state(p_state, p_index);
+	segment->set_text(text ? String::utf8(text) : String());
+
+	segment->set_speaker_turn_next(whisper_full_get_segment_speaker_turn_next_from_state(p_state, p_index));
+	segment->set_no_speech_prob(whisper_full_get_segment_no_speech_prob_from_state(p_state, p_index));
+
+	return segment;
+}
+
+/* --- async job pool --- */
+
+void WhisperFull::_start_workers() {
+	if (!worker_threads.is_empty()) {
+		return;
+	}
+
+	workers_stop.clear();
+
+	// states are created by the workers themselves once the context is ready
+	worker_states.resize(n_workers);
+	for (int i = 0; i < n_workers; i++) {
+		worker_states[i] = nullptr;
+
+		Ref<Thread> thread;
+		thread.instantiate();
+		thread->start(Callable(this, "_job_worker_func").bind(i));
+		worker_threads.push_back(thread);
+	}
+}
+
+void WhisperFull::_stop_workers() {
+	if (worker_threads.is_empty()) {
+		return;
+	}
+
+	// running jobs finish, queued jobs stay queued
+	workers_stop.set();
+	for (uint32_t i = 0; i < worker_threads.size(); i++) {
+		job_sem->post();
+	}
+
+	for (const Ref<Thread> &thread : worker_threads) {
+		thread->wait_to_finish();
+	}
+	worker_threads.clear();
+
+	for (whisper_state *worker_state : worker_states) {
+		if (worker_state != nullptr) {
+			whisper_free_state(worker_state);
+		}
+	}
+	worker_states.clear();
+
+	// every worker consumed one post on its way out, whichever job or stop request it came from.
+	// the count is rebuilt from the queue so a restarted pool gets exactly one wakeup per queued job
+	job_mtx->lock();
+	while (job_sem->try_wait()) {
+	}
+	for (uint32_t i = 0; i < (uint32_t)job_queue.size(); i++) {
+		job_sem->post();
+	}
+	job_mtx->unlock();
+}
+
+// restarts the pool for jobs left queued by _free_context, once the new settings are stored
+void WhisperFull::_resume_workers() {
+	job_mtx->lock();
+	bool has_jobs = !job_queue.is_empty();
+	job_mtx->unlock();
+
+	if (has_jobs) {
+		_start_workers();
+	}
+}
+
+void WhisperFull::_job_worker_func(int p_index) {
+	while (true) {
+		job_sem->wait();
+
+		if (workers_stop.is_set()) {
+			break;
+		}
+
+		Ref<WhisperJob> job;
+		job_mtx->lock();
+		if (!job_queue.is_empty()) {
+			job = job_queue.front()->get();
+			job_queue.pop_front();
+		}
+		job_mtx->unlock();
+
+		if (job.is_null()) {
+			continue;
+		}
+
+		if (job->cancel_requested.is_set()) {
+			job->result = -1;
+			job->_finish(WhisperJob::STATUS_CANCELED);
+			_queue_finished_job(job);
+			continue;
+		}
+
+		// the context is loaded lazily, so submitting a job never blocks on a model load
+		whisper_state *worker_state = worker_states[p_index];
+		if (worker_state == nullptr && _init_context()) {
+			worker_state = whisper_init_state(ctx);
+			worker_states[p_index] = worker_state;
+		}
+
+		if (worker_state == nullptr && load_canceled.is_set()) {
+			// the context is being freed and the pool stopped, the job runs with the next one
+			job_mtx->lock();
+			job_queue.push_front(job);
+			job_mtx->unlock();
+			break;
+		}
+
+		if (worker_state == nullptr) {
+			job->result = -1;
+			job->_finish(WhisperJob::STATUS_FAILED);
+			_queue_finished_job(job);
+			continue;
+		}
+
+		_run_job(job, worker_state);
+		_queue_finished_job(job);
+	}
+}
+
+void WhisperFull::_run_job(const Ref<WhisperJob> &p_job, whisper_state *p_state) {
+	uint64_t t_start = Time::get_singleton()->get_ticks_usec();
+	p_job->queue_ms = (t_start - p_job->submit_usec) / 1000.0f;
+	p_job->status.set(WhisperJob::STATUS_RUNNING);
+
+	whisper_full_params params = p_job->params;
+	CallbackData call_data;
+	call_data.self = this;
+	call_data.job = p_job.ptr();
+	_begin_call(call_data);
+	_set_callbacks(params, &call_data, true);
+
+	// applied with the instance's settings when the job starts
+	_apply_audio_ctx(params, p_job->samples.size());
+	p_job->audio_ctx = params.audio_ctx > 0 ? params.audio_ctx : whisper_n_audio_ctx(ctx);
+
+	p_job->result = whisper_full_with_state(ctx, p_state, params, p_job->samples.ptr(), p_job->samples.size());
+	metrics.record(METRIC_QUEUE, t_start - p_job->submit_usec);
+	_end_call(call_data, p_job->samples.size());
+	if (call_data.aborted) {
+		p_job->result = -1;
+	}
+
+	if (p_job->result == 0) {
+		ResultChunk chunk;
+		chunk.state = p_state;
+		chunk.n_segments = whisper_full_n_segments_from_state(p_state);
+		for (int i = 0; i < chunk.n_segments; i++) {
+			p_job->segments.push_back(_make_segment(p_state, i, 0));
+		}
+		p_job->text = _join_segment_texts(&chunk, 1);
+	}
+
+	p_job->process_ms = (Time::get_singleton()->get_ticks_usec() - t_start) / 1000.0f;
+	p_job->samples = PackedFloat32Array(); // audio is no longer needed
+
+	if (call_data.aborted) {
+		p_job->_finish(WhisperJob::STATUS_CANCELED);
+	} else {
+		p_job->_finish(p_job->result == 0 ? WhisperJob::STATUS_COMPLETED : WhisperJob::STATUS_FAILED);
+	}
+}
+
+// called from the workers, one deferred call delivers every job finished before it runs
+void WhisperFull::_queue_finished_job(const Ref<WhisperJob> &p_job) {
+	job_mtx->lock();
+	bool emit_queued = !finished_jobs.is_empty();
+	finished_jobs.push_back(p_job);
+	job_mtx->unlock();
+
+	if (!emit_queued) {
+		call_deferred("_emit_finished_jobs");
+	}
+}
+
+void WhisperFull::_emit_finished_jobs() {
+	// segments streamed by the jobs are delivered before their completion
+	_flush_stream_events();
+
+	while (true) {
+		Ref<WhisperJob> job;
+		job_mtx->lock();
+		if (!finished_jobs.is_empty()) {
+			job = finished_jobs.front()->get();
+			finished_jobs.pop_front();
+		}
+		job_mtx->unlock();
+
+		if (job.is_null()) {
+			break;
+		}
+
+		job->emit_signal("completed");
+		emit_signal("job_completed", job);
+	}
+}
+
+/* --- whisper callbacks --- */
+
+// captures the cancel generation and deadline, must be called on the thread starting the call
+void WhisperFull::_begin_call(CallbackData &r_data) const {
+	r_data.cancel_generation = cancel_generation.get();
+	r_data.deadline_usec = max_decode_ms > 0 ? Time::get_singleton()->get_ticks_usec() + (uint64_t)max_decode_ms * 1000 : 0;
+	r_data.aborted = false;
+	_start_timing(r_data);
+}
+
+void WhisperFull::_start_timing(CallbackData &r_data) {
+	r_data.t_call_usec = Time::get_singleton()->get_ticks_usec();
+	r_data.t_encode_usec.store(0);
+	r_data.t_decode_usec.store(0);
+	r_data.mel_usec = 0;
+	r_data.encode_usec.store(0);
+	r_data.decode_usec = 0;
+	r_data.encoder_started = false;
+}
+
+// closes the stage still running when whisper_full returned and records the call
+void WhisperFull::_end_call(CallbackData &r_data, int p_n_samples) {
+	uint64_t now = Time::get_singleton()->get_ticks_usec();
+	uint64_t t_encode = r_data.t_encode_usec.exchange(0);
+	if (t_encode != 0) {
+		r_data.encode_usec.fetch_add(now - t_encode);
+	}
+	uint64_t t_decode = r_data.t_decode_usec.exchange(0);
+	if (t_decode != 0) {
+		r_data.decode_usec += now - t_decode;
+	}
+
+	uint64_t total_usec = now - r_data.t_call_usec;
+	if (r_data.encoder_started) {
+		uint64_t encode_usec = r_data.encode_usec.load();
+		metrics.record(METRIC_MEL, r_data.mel_usec);
+		metrics.record(METRIC_ENCODE, encode_usec);
+		metrics.record(METRIC_DECODE, r_data.decode_usec);
+		t_encode_us.add(encode_usec);
+		t_decode_us.add(r_data.decode_usec);
+	}
+	metrics.record(METRIC_TOTAL, total_usec);
+
+	// in thousandths, processing time over audio time
+	uint64_t audio_usec = (uint64_t)p_n_samples * 1000000 / WHISPER_SAMPLE_RATE;
+	if (audio_usec > 0) {
+		metrics.record(METRIC_RTF, total_usec * 1000 / audio_usec);
+	}
+}
+
+void WhisperFull::_set_callbacks(whisper_full_params &r_params, CallbackData *p_data, bool p_report_progress) const {
+	// abort_callback is polled by ggml during encoding and decoding,
+	// encoder_begin_callback skips the encoder of the next window
+	r_params.abort_callback = _on_abort;
+	r_params.abort_callback_user_data = p_data;
+	r_params.encoder_begin_callback = _on_encoder_begin;
+	r_params.encoder_begin_callback_user_data = p_data;
+	r_params.logits_filter_callback = _on_logits_filter;
+	r_params.logits_filter_callback_user_data = p_data;
+
+	if (!stream_signals) {
+		return;
+	}
+
+	r_params.new_segment_callback = _on_new_segment;
+	r_params.new_segment_callback_user_data = p_data;
+
+	if (p_report_progress) {
+		r_params.progress_callback = _on_progress;
+		r_params.progress_callback_user_data = p_data;
+	}
+}
+
+void WhisperFull::_queue_stream_event(const StreamEvent &p_event) {
+	stream_events.push(p_event);
+
+	// one deferred flush for however many events arrive before it runs
+	if (!stream_flush_queued.exchange(true)) {
+		call_deferred("_flush_stream_events");
+	}
+}
+
+void WhisperFull::_flush_stream_events() {
+	// cleared before draining, so events pushed meanwhile either get drained here or queue a new flush
+	stream_flush_queued.store(false);
+
+	StreamEvent event;
+	while (stream_events.pop(event)) {
+		Object *target = event.job.is_valid() ? (Object *)event.job.ptr() : (Object *)this;
+		if (event.segment.is_valid()) {
+			target->emit_signal("segment_ready", event.segment);
+		} else {
+			target->emit_signal("progress", event.progress);
+		}
+	}
+}
+
+bool WhisperFull::_should_abort(CallbackData *p_data) {
+	if (p_data->aborted) {
+		return true;
+	}
+
+	bool abort = p_data->self->cancel_generation.get() != p_data->cancel_generation;
+	abort = abort || (p_data->hooks != nullptr && p_data->hooks->cancel != nullptr && p_data->hooks->cancel->is_set());
+	abort = abort || (p_data->job != nullptr && p_data->job->cancel_requested.is_set());
+	abort = abort || (p_data->deadline_usec > 0 && Time::get_singleton()->get_ticks_usec() > p_data->deadline_usec);
+
+	p_data->aborted = abort;
+	return abort;
+}
+
+bool WhisperFull::_on_abort(void *p_user_data) {
+	return _should_abort((CallbackData *)p_user_data);
+}
+
+bool WhisperFull::_on_encoder_begin(whisper_context *p_ctx, whisper_state *p_state, void *p_user_data) {
+	CallbackData *data = (CallbackData *)p_user_data;
+
+	uint64_t now = Time::get_singleton()->get_ticks_usec();
+	if (!data->encoder_started) {
+		// everything before the first encode is the spectrogram (and whisper's vad, if enabled)
+		data->mel_usec = now - data->t_call_usec;
+		data->encoder_started = true;
+	}
+	// the decoders of the previous window are done, nothing else touches the timestamps now
+	uint64_t t_decode = data->t_decode_usec.exchange(0);
+	if (t_decode != 0) {
+		data->decode_usec += now - t_decode;
+	}
+	data->t_encode_usec.store(now);
+
+	return !_should_abort(data);
+}
+
+// called for every decoded token, possibly from several decoder threads at once.
+// only the first one after an encode is timed, whichever thread claims the encode's start
+void WhisperFull::_on_logits_filter(whisper_context *p_ctx, whisper_state *p_state, const whisper_token_data *p_tokens, int p_n_tokens, float *p_logits, void *p_user_data) {
+	CallbackData *data = (CallbackData *)p_user_data;
+	uint64_t t_encode = data->t_encode_usec.load();
+	if (t_encode == 0 || !data->t_encode_usec.compare_exchange_strong(t_encode, 0)) {
+		return;
+	}
+
+	uint64_t now = Time::get_singleton()->get_ticks_usec();
+	data->encode_usec.fetch_add(now - t_encode);
+	data->t_decode_usec.store(now);
+}
+
+/* --- streaming results --- */
+
+// called from the thread running whisper_full whenever new segments are decoded
+void WhisperFull::_on_new_segment(whisper_context *p_ctx, whisper_state *p_state, int p_n_new, void *p_user_data) {
+	CallbackData *data = (CallbackData *)p_user_data;
+
+	int n_segments = whisper_full_n_segments_from_state(p_state);
+	for (int i = MAX(0, n_segments - p_n_new); i < n_segments; i++) {
+		StreamEvent event;
+		event.job = Ref<WhisperJob>(data->job);
+		event.segment = data->self->_make_segment(p_state, i, data->t_offset);
+
+		// unlike segment_ready, the caller's hook only sees the segments of its own call
+		if (data->hooks != nullptr && data->hooks->segment_callback != nullptr) {
+			data->hooks->segment_callback(data->hooks->userdata, event.segment);
+		}
+
+		data->self->_queue_stream_event(event);
+	}
+}
+
+void WhisperFull::_on_progress(whisper_context *p_ctx, whisper_state *p_state, int p_progress, void *p_user_data) {
+	CallbackData *data = (CallbackData *)p_user_data;
+	if (p_progress == data->last_progress) {
+		return;
+	}
+	data->last_progress = p_progress;
+
+	StreamEvent event;
+	event.job = Ref<WhisperJob>(data->job);
+	event.progress = p_progress;
+	data->self->_queue_stream_event(event);
+}
+
+whisper_state *WhisperFull::_get_parallel_state(int p_index) const {
+	// the first chunk always runs on the instance's own state
+	return p_index == 0 ? state : parallel_states[p_index - 1];
+}
+
+// picks where to cut between p_from and p_to, as close to p_target as possible.
+// the middle of a pause found by the voice detector is preferred, so no word is cut in half and
+// each chunk starts on fresh speech, otherwise the quietest 20ms frame is used
+int WhisperFull::_find_parallel_split(const float *p_samples, int p_from, int p_to, int p_target) const {
+	const int frame_size = WHISPER_SAMPLE_RATE / 50;
+	if (p_to - p_from < frame_size) {
+		return p_target;
+	}
+
+	WhisperVoiceDetector detector;
+	detector.set_hangover_ms(200);
+
+	// a second before the range lets the noise floor settle
+	int warmup_from = MAX(0, p_from - WHISPER_SAMPLE_RATE);
+	for (int i = warmup_from; i + frame_size <= p_from; i += frame_size) {
+		WhisperVoiceDetector::Event event;
+		detector.process(p_samples + i, frame_size, event);
+	}
+
+	int best_split = -1;
+	int silence_from = -1;
+	int quietest_split = p_target;
+	float quietest_energy = FLT_MAX;
+
+	for (int i = p_from; i + frame_size <= p_to; i += frame_size) {
+		const float *frame = p_samples + i;
+
+		float energy = 0.0f;
+		for (int j = 0; j < frame_size; j++) {
+			energy += frame[j] * frame[j];
+		}
+		if (energy < quietest_energy || (energy == quietest_energy && ABS(i - p_target) < ABS(quietest_split - p_target))) {
+			quietest_energy = energy;
+			quietest_split = i + frame_size / 2;
+		}
+
+		// the detector consumes whole frames unless the state changes on the last sample
+		int consumed = 0;
+		while (consumed < frame_size) {
+			WhisperVoiceDetector::Event event;
+			consumed += detector.process(frame + consumed, frame_size - consumed, event);
+		}
+
+		bool silent = !detector.is_speaking();
+		bool last = i + frame_size * 2 > p_to;
+		if (silent && silence_from < 0) {
+			silence_from = i;
+		}
+		if (silence_from >= 0 && (!silent || last)) {
+			int silence_to = silent ? i + frame_size : i;
+			int split = (silence_from + silence_to) / 2;
+			if (best_split < 0 || ABS(split - p_target) < ABS(best_split - p_target)) {
+				best_split = split;
+			}
+			silence_from = -1;
+		}
+	}
+
+	return best_split >= 0 ? best_split : quietest_split;
+}
+
+void WhisperFull::_parallel_chunk_task(int p_index) {
+	int start = parallel_offsets[p_index];
+	int end = parallel_offsets[p_index + 1];
+
+	// segments are streamed with global timestamps, progress is only reported by the first chunk
+	whisper_full_params params = parallel_params;
+	CallbackData call_data;
+	call_data.self = this;
+	call_data.cancel_generation = parallel_call.cancel_generation;
+	call_data.deadline_usec = parallel_call.deadline_usec;
+	call_data.t_offset = (int64_t)start * 100 / WHISPER_SAMPLE_RATE;
+	_set_callbacks(params, &call_data, p_index == 0);
+	_apply_audio_ctx(params, end - start);
+
+	_start_timing(call_data);
+	parallel_results[p_index] = whisper_full_with_state(ctx, _get_parallel_state(p_index), params, parallel_samples + start, end - start);
+	_end_call(call_data, end - start);
+	parallel_aborted[p_index] = call_data.aborted;
+}
+
+void WhisperFull::_set_single_result(whisper_state *p_state) {
+	result_chunks.clear();
+
+	ResultChunk chunk;
+	chunk.state = p_state;
+	chunk.n_segments = whisper_full_n_segments_from_state(p_state);
+	result_chunks.push_back(chunk);
+
+	result_segment_count = chunk.n_segments;
+}
+
+whisper_state *WhisperFull::_resolve_segment(int p_index, int &r_local_index, int64_t &r_t_offset) const {
+	for (const ResultChunk &chunk : result_chunks) {
+		if (p_index < chunk.n_segments) {
+			r_local_index = p_index;
+			r_t_offset = chunk.t_offset;
+			return chunk.state;
+		}
+		p_index -= chunk.n_segments;
+	}
+	return nullptr;
+}
+
+// measures the utf8 of every segment first, so the text is copied once and decoded once
+String WhisperFull::_join_segment_texts(const ResultChunk *p_chunks, int p_n_chunks) {
+	size_t n_bytes = 0;
+	for (int c = 0; c < p_n_chunks; c++) {
+		for (int i = 0; i < p_chunks[c].n_segments; i++) {
+			const char *text = whisper_full_get_segment_text_from_state(p_chunks[c].state, i);
+			n_bytes += text ? strlen(text) : 0;
+		}
+	}
+
+	if (n_bytes == 0) {
+		return String();
+	}
+
+	// a single segment is decoded in place
+	if (p_n_chunks == 1 && p_chunks[0].n_segments == 1) {
+		return String::utf8(whisper_full_get_segment_text_from_state(p_chunks[0].state, 0), n_bytes);
+	}
+
+	LocalVector<char> utf8;
+	utf8.resize(n_bytes);
+	char *dst = utf8.ptr();
+	for (int c = 0; c < p_n_chunks; c++) {
+		for (int i = 0; i < p_chunks[c].n_segments; i++) {
+			const char *text = whisper_full_get_segment_text_from_state(p_chunks[c].state, i);
+			if (text) {
+				size_t length = strlen(text);
+				memcpy(dst, text, length);
+				dst += length;
+			}
+		}
+	}
+
+	return String::utf8(utf8.ptr(), n_bytes);
+}
+
+// the encoder always runs over audio_ctx frames (1500 = 30s by default), short audio is zero padded up to it.
+// one frame is two mel hops (20ms), the margin keeps some padding after the speech
+void WhisperFull::_apply_audio_ctx(whisper_full_params &r_params, int p_n_samples) const {
+	const int n_audio_ctx = whisper_n_audio_ctx(ctx);
+
+	if (audio_ctx_auto) {
+		const int samples_per_frame = WHISPER_HOP_LENGTH * 2;
+
+		int n_samples = MAX(0, p_n_samples - r_params.offset_ms * (WHISPER_SAMPLE_RATE / 1000));
+		if (r_params.duration_ms > 0) {
+			n_samples = MIN(n_samples, r_params.duration_ms * (WHISPER_SAMPLE_RATE / 1000));
+		}
+		n_samples += audio_ctx_margin_ms * (WHISPER_SAMPLE_RATE / 1000);
+
+		r_params.audio_ctx = (n_samples + samples_per_frame - 1) / samples_per_frame;
+	}
+
+	// larger values are rejected by whisper_full
+	if (r_params.audio_ctx <= 0 || r_params.audio_ctx >= n_audio_ctx) {
+		r_params.audio_ctx = 0;
+	}
+}
+
+void WhisperFull::_record_timing(uint64_t p_start_usec) {
+	t_last_us = Time::get_singleton()->get_ticks_usec() - p_start_usec;
+	t_total_us += t_last_us;
+	n_calls++;
+}
+
 void WhisperFull::_bind_methods() {
 	// model management
 	ClassDB::bind_method(D_METHOD("set_model", "model"), &WhisperFull::set_model);
@@ -199,6 +1018,15 @@ void WhisperFull::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_n_max_text_ctx", "n_max_text_ctx"), &WhisperFull::set_n_max_text_ctx);
 	ClassDB::bind_method(D_METHOD("get_n_max_text_ctx"), &WhisperFull::get_n_max_text_ctx);
 
+	ClassDB::bind_method(D_METHOD("set_n_workers", "n_workers"), &WhisperFull::set_n_workers);
+	ClassDB::bind_method(D_METHOD("get_n_workers"), &WhisperFull::get_n_workers);
+
+	ClassDB::bind_method(D_METHOD("set_parallel_split_on_silence", "parallel_split_on_silence"), &WhisperFull::set_parallel_split_on_silence);
+	ClassDB::bind_method(D_METHOD("get_parallel_split_on_silence"), &WhisperFull::get_parallel_split_on_silence);
+
+	ClassDB::bind_method(D_METHOD("set_parallel_split_search_ms", "parallel_split_search_ms"), &WhisperFull::set_parallel_split_search_ms);
+	ClassDB::bind_method(D_METHOD("get_parallel_split_search_ms"), &WhisperFull::get_parallel_split_search_ms);
+
 	// full params - timing
 	ClassDB::bind_method(D_METHOD("set_offset_ms", "offset_ms"), &WhisperFull::set_offset_ms);
 	ClassDB::bind_method(D_METHOD("get_offset_ms"), &WhisperFull::get_offset_ms);
@@ -257,12 +1085,25 @@ void WhisperFull::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_audio_ctx", "audio_ctx"), &WhisperFull::set_audio_ctx);
 	ClassDB::bind_method(D_METHOD("get_audio_ctx"), &WhisperFull::get_audio_ctx);
 
+	ClassDB::bind_method(D_METHOD("set_audio_ctx_auto", "audio_ctx_auto"), &WhisperFull::set_audio_ctx_auto);
+	ClassDB::bind_method(D_METHOD("get_audio_ctx_auto"), &WhisperFull::get_audio_ctx_auto);
+
+	ClassDB::bind_method(D_METHOD("set_audio_ctx_margin_ms", "audio_ctx_margin_ms"), &WhisperFull::set_audio_ctx_margin_ms);
+	ClassDB::bind_method(D_METHOD("get_audio_ctx_margin_ms"), &WhisperFull::get_audio_ctx_margin_ms);
+
 	ClassDB::bind_method(D_METHOD("set_tdrz_enable", "tdrz_enable"), &WhisperFull::set_tdrz_enable);
 	ClassDB::bind_method(D_METHOD("get_tdrz_enable"), &WhisperFull::get_tdrz_enable);
 
 	ClassDB::bind_method(D_METHOD("set_suppress_regex", "suppress_regex"), &WhisperFull::set_suppress_regex);
 	ClassDB::bind_method(D_METHOD("get_suppress_regex"), &WhisperFull::get_suppress_regex);
 
+	// streaming
+	ClassDB::bind_method(D_METHOD("set_max_decode_ms", "max_decode_ms"), &WhisperFull::set_max_decode_ms);
+	ClassDB::bind_method(D_METHOD("get_max_decode_ms"), &WhisperFull::get_max_decode_ms);
+
+	ClassDB::bind_method(D_METHOD("set_stream_signals", "stream_signals"), &WhisperFull::set_stream_signals);
+	ClassDB::bind_method(D_METHOD("get_stream_signals"), &WhisperFull::get_stream_signals);
+
 	// full params - prompt
 	ClassDB::bind_method(D_METHOD("set_initial_prompt", "initial_prompt"), &WhisperFull::set_initial_prompt);
 	ClassDB::bind_method(D_METHOD("get_initial_prompt"), &WhisperFull::get_initial_prompt);
@@ -346,6 +1187,8 @@ void WhisperFull::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("is_initialized"), &WhisperFull::is_initialized);
 	ClassDB::bind_method(D_METHOD("init"), &WhisperFull::init);
 	ClassDB::bind_method(D_METHOD("free_context"), &WhisperFull::free_context);
+	ClassDB::bind_method(D_METHOD("init_async"), &WhisperFull::init_async);
+	ClassDB::bind_method(D_METHOD("is_loading"), &WhisperFull::is_loading);
 
 	// model info
 	ClassDB::bind_method(D_METHOD("is_multilingual"), &WhisperFull::is_multilingual);
@@ -374,12 +1217,21 @@ void WhisperFull::_bind_methods() {
 
 
 	ClassDB::bind_method(D_METHOD("transcribe", "samples"), &WhisperFull::transcribe);
-	ClassDB::bind_method(D_METHOD("transcribe_parallel", "samples", "n_processors"), &WhisperFull::transcribe_parallel);
+	ClassDB::bind_method(D_METHOD("transcribe_mel", "mel", "n_samples"), &WhisperFull::transcribe_mel);
+	ClassDB::bind_method(D_METHOD("transcribe_file", "path"), &WhisperFull::transcribe_file);
+	ClassDB::bind_method(D_METHOD("transcribe_parallel", "samples", "n_processors"), &WhisperFull::transcribe_parallel, DEFVAL(0));
+	ClassDB::bind_method(D_METHOD("transcribe_batch", "windows"), &WhisperFull::transcribe_batch);
+	ClassDB::bind_method(D_METHOD("transcribe_async", "samples"), &WhisperFull::transcribe_async);
+	ClassDB::bind_method(D_METHOD("get_pending_job_count"), &WhisperFull::get_pending_job_count);
+	ClassDB::bind_method(D_METHOD("cancel"), &WhisperFull::cancel);
+	ClassDB::bind_method(D_METHOD("was_canceled"), &WhisperFull::was_canceled);
 
 	ClassDB::bind_method(D_METHOD("get_segment_count"), &WhisperFull::get_segment_count);
 	ClassDB::bind_method(D_METHOD("get_segment", "index"), &WhisperFull::get_segment);
 	ClassDB::bind_method(D_METHOD("get_all_segments"), &WhisperFull::get_all_segments);
 	ClassDB::bind_method(D_METHOD("get_full_text"), &WhisperFull::get_full_text);
+	ClassDB::bind_method(D_METHOD("get_segments_packed"), &WhisperFull::get_segments_packed);
+	ClassDB::bind_method(D_METHOD("get_tokens_packed", "include_special"), &WhisperFull::get_tokens_packed, DEFVAL(false));
 
 	ClassDB::bind_method(D_METHOD("get_detected_lang_id"), &WhisperFull::get_detected_lang_id);
 	ClassDB::bind_method(D_METHOD("get_detected_language"), &WhisperFull::get_detected_language);
@@ -388,6 +1240,12 @@ void WhisperFull::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("print_timings"), &WhisperFull::print_timings);
 	ClassDB::bind_method(D_METHOD("reset_timings"), &WhisperFull::reset_timings);
 
+	ClassDB::bind_method(D_METHOD("get_metrics"), &WhisperFull::get_metrics);
+	ClassDB::bind_method(D_METHOD("reset_metrics"), &WhisperFull::reset_metrics);
+	ClassDB::bind_method(D_METHOD("add_performance_monitors", "prefix"), &WhisperFull::add_performance_monitors, DEFVAL("Whisper"));
+	ClassDB::bind_method(D_METHOD("remove_performance_monitors"), &WhisperFull::remove_performance_monitors);
+	ClassDB::bind_method(D_METHOD("_get_metric", "stage", "percentile"), &WhisperFull::_get_metric);
+
 	ClassDB::bind_static_method("WhisperFull", D_METHOD("get_system_info"), &WhisperFull::get_system_info);
 	ClassDB::bind_static_method("WhisperFull", D_METHOD("get_version"), &WhisperFull::get_version);
 	ClassDB::bind_static_method("WhisperFull", D_METHOD("get_sample_rate"), &WhisperFull::get_sample_rate);
@@ -395,6 +1253,26 @@ void WhisperFull::_bind_methods() {
 	// utilities
 	ClassDB::bind_static_method("WhisperFull", D_METHOD("convert_stereo_to_mono_16khz", "from_sample_rate", "samples"), &WhisperFull::convert_stereo_to_mono_16khz);
 
+	// internal task function (must be callable for WorkerThreadPool)
+	ClassDB::bind_method(D_METHOD("_parallel_chunk_task", "index"), &WhisperFull::_parallel_chunk_task);
+	ClassDB::bind_method(D_METHOD("_batch_task", "index"), &WhisperFull::_batch_task);
+
+	// internal async init functions (must be callable for Thread / call_deferred)
+	ClassDB::bind_method(D_METHOD("_init_thread_func", "init_id"), &WhisperFull::_init_thread_func);
+	ClassDB::bind_method(D_METHOD("_finish_init_async", "success", "init_id"), &WhisperFull::_finish_init_async);
+
+	// internal job pool functions (must be callable for Thread / call_deferred)
+	ClassDB::bind_method(D_METHOD("_job_worker_func", "index"), &WhisperFull::_job_worker_func);
+	ClassDB::bind_method(D_METHOD("_emit_finished_jobs"), &WhisperFull::_emit_finished_jobs);
+	ClassDB::bind_method(D_METHOD("_flush_stream_events"), &WhisperFull::_flush_stream_events);
+
+	ADD_SIGNAL(MethodInfo("initialized"));
+	ADD_SIGNAL(MethodInfo("init_failed", PropertyInfo(Variant::STRING, "error")));
+	ADD_SIGNAL(MethodInfo("init_progress", PropertyInfo(Variant::INT, "bytes_loaded"), PropertyInfo(Variant::INT, "bytes_total")));
+	ADD_SIGNAL(MethodInfo("job_completed", PropertyInfo(Variant::OBJECT, "job", PROPERTY_HINT_RESOURCE_TYPE, "WhisperJob")));
+	ADD_SIGNAL(MethodInfo("segment_ready", PropertyInfo(Variant::OBJECT, "segment", PROPERTY_HINT_RESOURCE_TYPE, "WhisperSegment")));
+	ADD_SIGNAL(MethodInfo("progress", PropertyInfo(Variant::INT, "progress")));
+
 	// note : this class is not Resource-based. so there's no way to display properties in the inspector ?
 
 	ADD_GROUP("Model", "");
@@ -411,6 +1289,11 @@ void WhisperFull::_bind_methods() {
 	ADD_GROUP("Threading", "");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "n_threads"), "set_n_threads", "get_n_threads");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "n_max_text_ctx"), "set_n_max_text_ctx", "get_n_max_text_ctx");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "n_workers", PROPERTY_HINT_RANGE, "1,64,1"), "set_n_workers", "get_n_workers");
+
+	ADD_GROUP("Parallel", "parallel_");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "parallel_split_on_silence"), "set_parallel_split_on_silence", "get_parallel_split_on_silence");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "parallel_split_search_ms", PROPERTY_HINT_RANGE, "0,60000,100,suffix:ms"), "set_parallel_split_search_ms", "get_parallel_split_search_ms");
 
 	ADD_GROUP("Timing", "");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "offset_ms"), "set_offset_ms", "get_offset_ms");
@@ -437,9 +1320,17 @@ void WhisperFull::_bind_methods() {
 	ADD_GROUP("Experimental", "");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "debug_mode"), "set_debug_mode", "get_debug_mode");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "audio_ctx"), "set_audio_ctx", "get_audio_ctx");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "audio_ctx_auto"), "set_audio_ctx_auto", "get_audio_ctx_auto");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "audio_ctx_margin_ms", PROPERTY_HINT_RANGE, "0,30000,20,suffix:ms"), "set_audio_ctx_margin_ms", "get_audio_ctx_margin_ms");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "tdrz_enable"), "set_tdrz_enable", "get_tdrz_enable");
 	ADD_PROPERTY(PropertyInfo(Variant::STRING, "suppress_regex"), "set_suppress_regex", "get_suppress_regex");
 
+	ADD_GROUP("Cancellation", "");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "max_decode_ms", PROPERTY_HINT_RANGE, "0,600000,100,suffix:ms"), "set_max_decode_ms", "get_max_decode_ms");
+
+	ADD_GROUP("Streaming", "");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "stream_signals"), "set_stream_signals", "get_stream_signals");
+
 	ADD_GROUP("Prompt", "");
 	ADD_PROPERTY(PropertyInfo(Variant::STRING, "initial_prompt"), "set_initial_prompt", "get_initial_prompt");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "carry_initial_prompt"), "set_carry_initial_prompt", "get_carry_initial_prompt");
@@ -487,10 +1378,12 @@ void WhisperFull::_bind_methods() {
 
 void WhisperFull::set_model(const Ref<WhisperModel> &p_model) {
 	// if model changes, free existing context
-	if (model != p_model) {
-		_free_context();
+	if (model == p_model) {
+		return;
 	}
+	_free_context();
 	model = p_model;
+	_resume_workers();
 }
 
 Ref<WhisperModel> WhisperFull::get_model() const {
@@ -498,10 +1391,12 @@ Ref<WhisperModel> WhisperFull::get_model() const {
 }
 
 void WhisperFull::set_use_gpu(bool p_use_gpu) {
-	if (use_gpu != p_use_gpu) {
-		_free_context(); // need to reinitialize
+	if (use_gpu == p_use_gpu) {
+		return;
 	}
+	_free_context(); // need to reinitialize
 	use_gpu = p_use_gpu;
+	_resume_workers();
 }
 
 bool WhisperFull::get_use_gpu() const {
@@ -509,10 +1404,12 @@ bool WhisperFull::get_use_gpu() const {
 }
 
 void WhisperFull::set_flash_attn(bool p_flash_attn) {
-	if (flash_attn != p_flash_attn) {
-		_free_context();
+	if (flash_attn == p_flash_attn) {
+		return;
 	}
+	_free_context();
 	flash_attn = p_flash_attn;
+	_resume_workers();
 }
 
 bool WhisperFull::get_flash_attn() const {
@@ -520,10 +1417,12 @@ bool WhisperFull::get_flash_attn() const {
 }
 
 void WhisperFull::set_gpu_device(int p_gpu_device) {
-	if (gpu_device != p_gpu_device) {
-		_free_context();
+	if (gpu_device == p_gpu_device) {
+		return;
 	}
+	_free_context();
 	gpu_device = p_gpu_device;
+	_resume_workers();
 }
 
 int WhisperFull::get_gpu_device() const {
@@ -554,6 +1453,41 @@ int WhisperFull::get_n_max_text_ctx() const {
 	return n_max_text_ctx;
 }
 
+void WhisperFull::set_n_workers(int p_n_workers) {
+	p_n_workers = CLAMP(p_n_workers, 1, 64);
+	if (n_workers == p_n_workers) {
+		return;
+	}
+
+	// running jobs finish first, the pool restarts with the new size
+	bool was_running = !worker_threads.is_empty();
+	_stop_workers();
+	n_workers = p_n_workers;
+	if (was_running) {
+		_start_workers();
+	}
+}
+
+int WhisperFull::get_n_workers() const {
+	return n_workers;
+}
+
+void WhisperFull::set_parallel_split_on_silence(bool p_parallel_split_on_silence) {
+	parallel_split_on_silence = p_parallel_split_on_silence;
+}
+
+bool WhisperFull::get_parallel_split_on_silence() const {
+	return parallel_split_on_silence;
+}
+
+void WhisperFull::set_parallel_split_search_ms(int p_parallel_split_search_ms) {
+	parallel_split_search_ms = MAX(p_parallel_split_search_ms, 0);
+}
+
+int WhisperFull::get_parallel_split_search_ms() const {
+	return parallel_split_search_ms;
+}
+
 void WhisperFull::set_offset_ms(int p_offset_ms) {
 	offset_ms = p_offset_ms;
 }
@@ -698,6 +1632,22 @@ int WhisperFull::get_audio_ctx() const {
 	return audio_ctx;
 }
 
+void WhisperFull::set_audio_ctx_auto(bool p_audio_ctx_auto) {
+	audio_ctx_auto = p_audio_ctx_auto;
+}
+
+bool WhisperFull::get_audio_ctx_auto() const {
+	return audio_ctx_auto;
+}
+
+void WhisperFull::set_audio_ctx_margin_ms(int p_audio_ctx_margin_ms) {
+	audio_ctx_margin_ms = MAX(p_audio_ctx_margin_ms, 0);
+}
+
+int WhisperFull::get_audio_ctx_margin_ms() const {
+	return audio_ctx_margin_ms;
+}
+
 void WhisperFull::set_tdrz_enable(bool p_tdrz_enable) {
 	tdrz_enable = p_tdrz_enable;
 }
@@ -714,6 +1664,22 @@ String WhisperFull::get_suppress_regex() const {
 	return suppress_regex;
 }
 
+void WhisperFull::set_max_decode_ms(int p_max_decode_ms) {
+	max_decode_ms = MAX(p_max_decode_ms, 0);
+}
+
+int WhisperFull::get_max_decode_ms() const {
+	return max_decode_ms;
+}
+
+void WhisperFull::set_stream_signals(bool p_stream_signals) {
+	stream_signals = p_stream_signals;
+}
+
+bool WhisperFull::get_stream_signals() const {
+	return stream_signals;
+}
+
 void WhisperFull::set_initial_prompt(const String &p_initial_prompt) {
 	initial_prompt = p_initial_prompt;
 }
@@ -909,7 +1875,7 @@ float WhisperFull::get_vad_samples_overlap() const {
 /* --- context management --- */
 
 bool WhisperFull::is_initialized() const {
-	return ctx != nullptr;
+	return initialized.is_set();
 }
 
 bool WhisperFull::init() {
@@ -920,6 +1886,32 @@ void WhisperFull::free_context() {
 	_free_context();
 }
 
+bool WhisperFull::init_async() {
+	if (initialized.is_set()) {
+		call_deferred("emit_signal", "initialized");
+		return true;
+	}
+
+	if (init_thread.is_valid()) {
+		return true; // already loading
+	}
+
+	ERR_FAIL_COND_V_MSG(model.is_null() || model->get_bin_path().is_empty(), false, "[WhisperFull] model is not set or has empty path");
+
+	init_progress.bytes_loaded = 0;
+	init_progress.bytes_total = 0;
+	init_progress_percent = -1;
+
+	init_thread.instantiate();
+	init_thread->start(Callable(this, "_init_thread_func").bind(init_id));
+
+	return true;
+}
+
+bool WhisperFull::is_loading() const {
+	return init_thread.is_valid();
+}
+
 /* --- model info --- */
 
 bool WhisperFull::is_multilingual() const {
@@ -1017,69 +2009,412 @@ String WhisperFull::get_lang_str_full(int p_id) {
 /* --- transcription methods --- */
 
 int WhisperFull::transcribe(const PackedFloat32Array &p_samples) {
+	return transcribe_native(p_samples.ptr(), p_samples.size());
+}
+
+// for callers that keep their audio in their own buffers
+int WhisperFull::transcribe_native(const float *p_samples, int p_n_samples, const WhisperCallHooks *p_hooks) {
 	if (!_init_context()) {
 		return -1;
 	}
 
-	whisper_full_params wparams = _build_params();
+	whisper_full_params wparams = _build_params(param_strings);
 
-	int result = whisper_full(ctx, wparams, p_samples.ptr(), p_samples.size());
+	CallbackData call_data;
+	call_data.self = this;
+	call_data.hooks = p_hooks;
+	_begin_call(call_data);
+	_set_callbacks(wparams, &call_data, true);
+	_apply_audio_ctx(wparams, p_n_samples);
+	last_audio_ctx = wparams.audio_ctx > 0 ? wparams.audio_ctx : whisper_n_audio_ctx(ctx);
 
-	return result;
+	uint64_t t_start = Time::get_singleton()->get_ticks_usec();
+	int result = whisper_full_with_state(ctx, state, wparams, p_samples, p_n_samples);
+	_record_timing(t_start);
+	_end_call(call_data, p_n_samples);
+
+	_set_single_result(state);
+
+	// whisper_full reports success when the encoder callback stopped it, partial results are kept
+	last_canceled = call_data.aborted;
+	return last_canceled ? -1 : result;
+}
+
+// the spectrogram is n_mels rows of frames, its length follows from the model's mel count
+int WhisperFull::transcribe_mel(const PackedFloat32Array &p_mel, int p_n_samples) {
+	if (!_init_context()) {
+		return -1;
+	}
+	return transcribe_mel_native(p_mel.ptr(), p_mel.size() / whisper_model_n_mels(ctx), p_n_samples);
+}
+
+// whisper_full_with_state skips its own mel computation when it gets no samples, so the spectrogram
+// set on the state is used as is. the mel includes whisper's 30s of padding, duration_ms keeps the
+// decoder from seeking into it
+int WhisperFull::transcribe_mel_native(const float *p_mel, int p_n_len, int p_n_samples, const WhisperCallHooks *p_hooks) {
+	if (!_init_context()) {
+		return -1;
+	}
+
+	if (whisper_set_mel_with_state(ctx, state, p_mel, p_n_len, whisper_model_n_mels(ctx)) != 0) {
+		ERR_PRINT("[WhisperFull] failed to set mel spectrogram");
+		return -1;
+	}
+
+	whisper_full_params wparams = _build_params(param_strings);
+	wparams.vad = false;
+
+	const int length_ms = int((int64_t)p_n_samples * 1000 / WHISPER_SAMPLE_RATE);
+	if (wparams.duration_ms == 0 || wparams.offset_ms + wparams.duration_ms > length_ms) {
+		wparams.duration_ms = MAX(length_ms - wparams.offset_ms, 10); // 0 would mean all of it
+	}
+
+	CallbackData call_data;
+	call_data.self = this;
+	call_data.hooks = p_hooks;
+	_begin_call(call_data);
+	_set_callbacks(wparams, &call_data, true);
+	_apply_audio_ctx(wparams, p_n_samples);
+	last_audio_ctx = wparams.audio_ctx > 0 ? wparams.audio_ctx : whisper_n_audio_ctx(ctx);
+
+	uint64_t t_start = Time::get_singleton()->get_ticks_usec();
+	int result = whisper_full_with_state(ctx, state, wparams, nullptr, 0);
+	_record_timing(t_start);
+	_end_call(call_data, p_n_samples);
+
+	_set_single_result(state);
+
+	last_canceled = call_data.aborted;
+	return last_canceled ? -1 : result;
 }
 
+// memory stays at one window plus one decoded chunk however long the file is.
+// a full window may end mid-sentence, so its last segment is not emitted and the next window starts
+// where that segment started. the state keeps the previous text as prompt (unless no_context is set)
+int WhisperFull::transcribe_file(const String &p_path) {
+	if (!_init_context()) {
+		return -1;
+	}
+
+	WhisperAudioFile file;
+	if (!file.open(p_path)) {
+		return -1;
+	}
+
+	const int window_samples = WHISPER_SAMPLE_RATE * WHISPER_CHUNK_SIZE;
+
+	whisper_full_params wparams = _build_params(param_strings);
+	wparams.offset_ms = 0;
+	wparams.duration_ms = 0;
+
+	CallbackData call_data;
+	call_data.self = this;
+	_begin_call(call_data);
+	_set_callbacks(wparams, &call_data, false);
+
+	// segments are queued below, once it is known whether they are final
+	wparams.new_segment_callback = nullptr;
+	wparams.new_segment_callback_user_data = nullptr;
+
+	LocalVector<float> window;
+	int64_t window_start = 0;
+	bool end_of_file = false;
+	int result = 0;
+
+	uint64_t t_start = Time::get_singleton()->get_ticks_usec();
+
+	while (true) {
+		while (!end_of_file && (int)window.size() < window_samples) {
+			end_of_file = !file.read(window);
+		}
+		if (window.is_empty()) {
+			break;
+		}
+
+		const int n_samples = MIN((int)window.size(), window_samples);
+		const bool is_last = end_of_file && (int)window.size() <= n_samples;
+
+		whisper_full_params window_params = wparams;
+		_apply_audio_ctx(window_params, n_samples);
+		last_audio_ctx = window_params.audio_ctx > 0 ? window_params.audio_ctx : whisper_n_audio_ctx(ctx);
+
+		call_data.t_offset = window_start * 100 / WHISPER_SAMPLE_RATE;
+		_start_timing(call_data);
+		result = whisper_full_with_state(ctx, state, window_params, window.ptr(), n_samples);
+		_end_call(call_data, n_samples);
+		if (result != 0 || call_data.aborted) {
+			break;
+		}
+
+		int n_segments = whisper_full_n_segments_from_state(state);
+		int n_final = n_segments;
+		int n_advance = n_samples;
+		if (!is_last && n_segments > 1) {
+			int advance = int(whisper_full_get_segment_t0_from_state(state, n_segments - 1) * WHISPER_SAMPLE_RATE / 100);
+			if (advance > 0 && advance < n_samples) {
+				n_final = n_segments - 1;
+				n_advance = advance;
+			}
+		}
+
+		for (int i = 0; i < n_final; i++) {
+			StreamEvent event;
+			event.segment = _make_segment(state, i, call_data.t_offset);
+			_queue_stream_event(event);
+		}
+
+		StreamEvent progress_event;
+		progress_event.progress = is_last ? 100 : int(file.get_progress() * 100.0f);
+		_queue_stream_event(progress_event);
+
+		if (is_last) {
+			break;
+		}
+
+		memmove(window.ptr(), window.ptr() + n_advance, (window.size() - n_advance) * sizeof(float));
+		window.resize(window.size() - n_advance);
+		window_start += n_advance;
+	}
+
+	_record_timing(t_start);
+
+	_set_single_result(state);
+	result_chunks[0].t_offset = call_data.t_offset;
+
+	last_canceled = call_data.aborted;
+	return last_canceled ? -1 : result;
+}
+
+// same splitting as whisper_full_parallel, which can't be used here because it
+// writes its results into the context's own state (contexts are shared and have none)
 int WhisperFull::transcribe_parallel(const PackedFloat32Array &p_samples, int p_n_processors) {
 	if (!_init_context()) {
 		return -1;
 	}
 
-	whisper_full_params wparams = _build_params();
+	const int n_samples = p_samples.size();
+	const int n_cores = OS::get_singleton()->get_processor_count();
+
+	// every chunk needs at least one second of audio
+	if (p_n_processors <= 0) {
+		p_n_processors = MAX(1, n_cores / MAX(1, n_threads));
+	}
+	const int n_processors = CLAMP(p_n_processors, 1, MAX(1, n_samples / WHISPER_SAMPLE_RATE));
+	if (n_processors == 1) {
+		return transcribe(p_samples);
+	}
+
+	while ((int)parallel_states.size() < n_processors - 1) {
+		whisper_state *parallel_state = whisper_init_state(ctx);
+		ERR_FAIL_NULL_V_MSG(parallel_state, -1, "[WhisperFull] failed to initialize whisper state for parallel processing");
+		parallel_states.push_back(parallel_state);
+	}
 
-	int result = whisper_full_parallel(ctx, wparams, p_samples.ptr(), p_samples.size(), p_n_processors);
+	parallel_params = _build_params(param_strings);
+	parallel_params.offset_ms = 0;
+	parallel_params.print_progress = false;
+	parallel_params.print_realtime = false;
+	parallel_samples = p_samples.ptr();
 
-	return result;
+	// chunks share the cores instead of each starting n_threads, oversubscription stops the scaling
+	parallel_params.n_threads = MAX(1, MIN(n_threads, n_cores / n_processors));
+
+	// only the cancel generation and deadline are used, every chunk times itself
+	parallel_call.self = this;
+	_begin_call(parallel_call);
+
+	parallel_offsets.resize(n_processors + 1);
+	for (int i = 0; i <= n_processors; i++) {
+		parallel_offsets[i] = int((int64_t)n_samples * i / n_processors);
+	}
+
+	// move the inner cuts to pauses, keeping a second of audio on both sides of each
+	if (parallel_split_on_silence) {
+		const int search = parallel_split_search_ms * (WHISPER_SAMPLE_RATE / 1000);
+		for (int i = 1; i < n_processors; i++) {
+			int target = parallel_offsets[i];
+			int from = MAX(parallel_offsets[i - 1] + WHISPER_SAMPLE_RATE, target - search);
+			int to = MIN(int((int64_t)n_samples * (i + 1) / n_processors) - WHISPER_SAMPLE_RATE, target + search);
+			if (from < to) {
+				parallel_offsets[i] = _find_parallel_split(parallel_samples, from, to, target);
+			} else {
+				parallel_offsets[i] = MAX(target, parallel_offsets[i - 1] + WHISPER_SAMPLE_RATE);
+			}
+		}
+	}
+
+	parallel_results.resize(n_processors);
+	parallel_aborted.resize(n_processors);
+
+	// chunks are within a search range of each other, the longest one stands for all of them
+	int longest_chunk = 0;
+	for (int i = 0; i < n_processors; i++) {
+		longest_chunk = MAX(longest_chunk, parallel_offsets[i + 1] - parallel_offsets[i]);
+	}
+	whisper_full_params chunk_params = parallel_params;
+	_apply_audio_ctx(chunk_params, longest_chunk);
+	last_audio_ctx = chunk_params.audio_ctx > 0 ? chunk_params.audio_ctx : whisper_n_audio_ctx(ctx);
+
+	uint64_t t_start = Time::get_singleton()->get_ticks_usec();
+
+	WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+	int64_t group_id = pool->add_group_task(Callable(this, "_parallel_chunk_task"), n_processors, n_processors, true, "WhisperFull::transcribe_parallel");
+	pool->wait_for_group_task_completion(group_id);
+
+	_record_timing(t_start);
+	parallel_samples = nullptr;
+
+	// stitch the chunks back together, shifting timestamps by each chunk's start
+	result_chunks.clear();
+	result_segment_count = 0;
+
+	int result = 0;
+	last_canceled = false;
+	for (int i = 0; i < n_processors; i++) {
+		if (parallel_results[i] != 0 && result == 0) {
+			result = parallel_results[i];
+		}
+		last_canceled = last_canceled || parallel_aborted[i];
+
+		ResultChunk chunk;
+		chunk.state = _get_parallel_state(i);
+		chunk.t_offset = (int64_t)parallel_offsets[i] * 100 / WHISPER_SAMPLE_RATE;
+		chunk.n_segments = whisper_full_n_segments_from_state(chunk.state);
+		result_chunks.push_back(chunk);
+
+		result_segment_count += chunk.n_segments;
+	}
+
+	return last_canceled ? -1 : result;
+}
+
+// whisper.cpp encodes one state per graph, so windows are batched by running them concurrently:
+// mel and encoder of every window overlap, and splitting n_threads between them scales better
+// than giving every thread to one window after the other
+TypedArray<WhisperJob> WhisperFull::transcribe_batch(const TypedArray<PackedFloat32Array> &p_windows) {
+	TypedArray<WhisperJob> jobs;
+
+	if (!_init_context()) {
+		return jobs;
+	}
+
+	const int n_windows = p_windows.size();
+	if (n_windows == 0) {
+		return jobs;
+	}
+
+	// batches have states of their own, so they don't touch the results of transcribe / transcribe_parallel
+	while ((int)batch_states.size() < n_windows) {
+		whisper_state *batch_state = whisper_init_state(ctx);
+		ERR_FAIL_NULL_V_MSG(batch_state, jobs, "[WhisperFull] failed to initialize whisper state for batched processing");
+		batch_states.push_back(batch_state);
+	}
+
+	uint64_t t_start = Time::get_singleton()->get_ticks_usec();
+
+	batch_jobs.resize(n_windows);
+	for (int i = 0; i < n_windows; i++) {
+		Ref<WhisperJob> job;
+		job.instantiate();
+		job->samples = p_windows[i];
+		job->params = _build_params(job->param_strings);
+		job->params.n_threads = MAX(1, n_threads / n_windows);
+		job->params.print_progress = false;
+		job->params.print_realtime = false;
+		job->submit_usec = t_start;
+
+		batch_jobs[i] = job;
+		jobs.push_back(job);
+	}
+
+	WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+	int64_t group_id = pool->add_group_task(Callable(this, "_batch_task"), n_windows, n_windows, true, "WhisperFull::transcribe_batch");
+	pool->wait_for_group_task_completion(group_id);
+
+	_record_timing(t_start);
+
+	// the jobs are returned done, only their streamed segments are still delivered deferred
+	batch_jobs.clear();
+
+	return jobs;
+}
+
+void WhisperFull::_batch_task(int p_index) {
+	_run_job(batch_jobs[p_index], batch_states[p_index]);
+}
+
+Ref<WhisperJob> WhisperFull::transcribe_async(const PackedFloat32Array &p_samples) {
+	ERR_FAIL_COND_V_MSG(model.is_null() || model->get_bin_path().is_empty(), Ref<WhisperJob>(), "[WhisperFull] model is not set or has empty path");
+
+	Ref<WhisperJob> job;
+	job.instantiate();
+	job->samples = p_samples;
+	job->params = _build_params(job->param_strings);
+	job->submit_usec = Time::get_singleton()->get_ticks_usec();
+
+	_start_workers();
+
+	job_mtx->lock();
+	job_queue.push_back(job);
+	job_mtx->unlock();
+
+	job_sem->post();
+
+	return job;
+}
+
+int WhisperFull::get_pending_job_count() const {
+	job_mtx->lock();
+	int count = job_queue.size();
+	job_mtx->unlock();
+	return count;
+}
+
+// safe to call from any thread, running calls return within one ggml graph node
+void WhisperFull::cancel() {
+	cancel_generation.increment();
+
+	job_mtx->lock();
+	for (List<Ref<WhisperJob>>::Element *E = job_queue.front(); E; E = E->next()) {
+		E->get()->cancel();
+	}
+	job_mtx->unlock();
+}
+
+bool WhisperFull::was_canceled() const {
+	return last_canceled;
 }
 
 /* --- get transcription results --- */
 
 int WhisperFull::get_segment_count() const {
 	ERR_FAIL_COND_V_MSG(ctx == nullptr, 0, "[WhisperFull] context not initialized");
-	return whisper_full_n_segments(ctx);
+	return result_segment_count;
 }
 
 Ref<WhisperSegment> WhisperFull::get_segment(int p_index) const {
 	ERR_FAIL_COND_V_MSG(ctx == nullptr, Ref<WhisperSegment>(), "[WhisperFull] context not initialized");
+	ERR_FAIL_INDEX_V_MSG(p_index, result_segment_count, Ref<WhisperSegment>(), "[WhisperFull] segment index out of range");
 
-	int n_segments = whisper_full_n_segments(ctx);
-	ERR_FAIL_INDEX_V_MSG(p_index, n_segments, Ref<WhisperSegment>(), "[WhisperFull] segment index out of range");
-
-	Ref<WhisperSegment> segment;
-	segment.instantiate();
-
-	// times are in centiseconds (1/100 sec), convert to milliseconds
-	segment->set_t0(whisper_full_get_segment_t0(ctx, p_index) * 10);
-	segment->set_t1(whisper_full_get_segment_t1(ctx, p_index) * 10);
-
-	const char *text = whisper_full_get_segment_text(ctx, p_index);
-	segment->set_text(text ? String::utf8(text) : String());
-
-	segment->set_speaker_turn_next(whisper_full_get_segment_speaker_turn_next(ctx, p_index));
-	segment->set_no_speech_prob(whisper_full_get_segment_no_speech_prob(ctx, p_index));
+	int index = 0;
+	int64_t t_offset = 0;
+	whisper_state *st = _resolve_segment(p_index, index, t_offset);
 
-	return segment;
+	return _make_segment(st, index, t_offset);
 }
 
 int WhisperFull::get_all_segments_native(LocalVector<Ref<WhisperSegment>> &r_segments) const {
 	ERR_FAIL_COND_V_MSG(ctx == nullptr, 0, "[WhisperFull] context not initialized");
 
-	int n_segments = whisper_full_n_segments(ctx);
 	uint32_t size = r_segments.size();
-	r_segments.resize(size + n_segments);
-	for (int i = 0; i < n_segments; i++) {
-		r_segments[size + i] = get_segment(i);
+	r_segments.resize(size + result_segment_count);
+	for (const ResultChunk &chunk : result_chunks) {
+		for (int i = 0; i < chunk.n_segments; i++) {
+			r_segments[size++] = _make_segment(chunk.state, i, chunk.t_offset);
+		}
 	}
 
-	return n_segments;
+	return result_segment_count;
 }
 
 TypedArray<WhisperSegment> WhisperFull::get_all_segments() const {
@@ -1087,9 +2422,12 @@ TypedArray<WhisperSegment> WhisperFull::get_all_segments() const {
 
 	ERR_FAIL_COND_V_MSG(ctx == nullptr, segments, "[WhisperFull] context not initialized");
 
-	int n_segments = whisper_full_n_segments(ctx);
-	for (int i = 0; i < n_segments; i++) {
-		segments.push_back(get_segment(i));
+	segments.resize(result_segment_count);
+	int index = 0;
+	for (const ResultChunk &chunk : result_chunks) {
+		for (int i = 0; i < chunk.n_segments; i++) {
+			segments[index++] = _make_segment(chunk.state, i, chunk.t_offset);
+		}
 	}
 
 	return segments;
@@ -1097,23 +2435,157 @@ TypedArray<WhisperSegment> WhisperFull::get_all_segments() const {
 
 String WhisperFull::get_full_text() const {
 	ERR_FAIL_COND_V_MSG(ctx == nullptr, String(), "[WhisperFull] context not initialized");
+	return _join_segment_texts(result_chunks.ptr(), result_chunks.size());
+}
 
-	String result;
-	int n_segments = whisper_full_n_segments(ctx);
+int WhisperFull::get_segments_packed_native(PackedInt64Array &r_t0, PackedInt64Array &r_t1, PackedFloat32Array &r_no_speech_prob, PackedByteArray &r_speaker_turn_next, PackedStringArray &r_text) const {
+	ERR_FAIL_COND_V_MSG(ctx == nullptr, 0, "[WhisperFull] context not initialized");
+
+	const int n_segments = result_segment_count;
+	r_t0.resize(n_segments);
+	r_t1.resize(n_segments);
+	r_no_speech_prob.resize(n_segments);
+	r_speaker_turn_next.resize(n_segments);
+	r_text.resize(n_segments);
+
+	int64_t *t0 = r_t0.ptrw();
+	int64_t *t1 = r_t1.ptrw();
+	float *no_speech_prob = r_no_speech_prob.ptrw();
+	uint8_t *speaker_turn_next = r_speaker_turn_next.ptrw();
+	String *text = r_text.ptrw();
+
+	int index = 0;
+	for (const ResultChunk &chunk : result_chunks) {
+		for (int i = 0; i < chunk.n_segments; i++, index++) {
+			// times are in centiseconds (1/100 sec), convert to milliseconds
+			t0[index] = (whisper_full_get_segment_t0_from_state(chunk.state, i) + chunk.t_offset) * 10;
+			t1[index] = (whisper_full_get_segment_t1_from_state(chunk.state, i) + chunk.t_offset) * 10;
+			no_speech_prob[index] = whisper_full_get_segment_no_speech_prob_from_state(chunk.state, i);
+			speaker_turn_next[index] = whisper_full_get_segment_speaker_turn_next_from_state(chunk.state, i) ? 1 : 0;
+
+			const char *segment_text = whisper_full_get_segment_text_from_state(chunk.state, i);
+			text[index] = segment_text ? String::utf8(segment_text) : String();
+		}
+	}
+
+	return n_segments;
+}
+
+Dictionary WhisperFull::get_segments_packed() const {
+	PackedInt64Array t0;
+	PackedInt64Array t1;
+	PackedFloat32Array no_speech_prob;
+	PackedByteArray speaker_turn_next;
+	PackedStringArray text;
+	get_segments_packed_native(t0, t1, no_speech_prob, speaker_turn_next, text);
+
+	Dictionary result;
+	result["t0"] = t0;
+	result["t1"] = t1;
+	result["no_speech_prob"] = no_speech_prob;
+	result["speaker_turn_next"] = speaker_turn_next;
+	result["text"] = text;
+	return result;
+}
 
-	for (int i = 0; i < n_segments; i++) {
-		const char *text = whisper_full_get_segment_text(ctx, i);
-		if (text) {
-			result += String::utf8(text);
+Dictionary WhisperFull::get_tokens_packed(bool p_include_special) const {
+	Dictionary result;
+	ERR_FAIL_COND_V_MSG(ctx == nullptr, result, "[WhisperFull] context not initialized");
+
+	// special tokens (timestamps, [_BEG_], ...) come after eot in the vocabulary
+	const whisper_token token_eot = whisper_token_eot(ctx);
+
+	// count first so every array is allocated once
+	int n_tokens = 0;
+	int64_t n_bytes = 0;
+	for (const ResultChunk &chunk : result_chunks) {
+		for (int i = 0; i < chunk.n_segments; i++) {
+			const int n = whisper_full_n_tokens_from_state(chunk.state, i);
+			for (int j = 0; j < n; j++) {
+				if (!p_include_special && whisper_full_get_token_id_from_state(chunk.state, i, j) >= token_eot) {
+					continue;
+				}
+				const char *text = whisper_full_get_token_text_from_state(ctx, chunk.state, i, j);
+				n_bytes += text ? strlen(text) : 0;
+				n_tokens++;
+			}
 		}
 	}
 
+	PackedInt32Array segment_index;
+	PackedInt32Array id;
+	PackedFloat32Array p;
+	PackedFloat32Array plog;
+	PackedInt64Array t0;
+	PackedInt64Array t1;
+	PackedByteArray text;
+	PackedInt32Array text_offset;
+	segment_index.resize(n_tokens);
+	id.resize(n_tokens);
+	p.resize(n_tokens);
+	plog.resize(n_tokens);
+	t0.resize(n_tokens);
+	t1.resize(n_tokens);
+	text.resize(n_bytes);
+	text_offset.resize(n_tokens + 1);
+
+	int32_t *segment_ptr = segment_index.ptrw();
+	int32_t *id_ptr = id.ptrw();
+	float *p_ptr = p.ptrw();
+	float *plog_ptr = plog.ptrw();
+	int64_t *t0_ptr = t0.ptrw();
+	int64_t *t1_ptr = t1.ptrw();
+	uint8_t *text_ptr = text.ptrw();
+	int32_t *offset_ptr = text_offset.ptrw();
+
+	int index = 0;
+	int segment = 0;
+	int64_t offset = 0;
+	for (const ResultChunk &chunk : result_chunks) {
+		for (int i = 0; i < chunk.n_segments; i++, segment++) {
+			const int n = whisper_full_n_tokens_from_state(chunk.state, i);
+			for (int j = 0; j < n; j++) {
+				const whisper_token_data data = whisper_full_get_token_data_from_state(chunk.state, i, j);
+				if (!p_include_special && data.id >= token_eot) {
+					continue;
+				}
+
+				segment_ptr[index] = segment;
+				id_ptr[index] = data.id;
+				p_ptr[index] = data.p;
+				plog_ptr[index] = data.plog;
+
+				// centiseconds to milliseconds, whisper leaves -1 without token timestamps
+				t0_ptr[index] = data.t0 >= 0 ? (data.t0 + chunk.t_offset) * 10 : -1;
+				t1_ptr[index] = data.t1 >= 0 ? (data.t1 + chunk.t_offset) * 10 : -1;
+
+				offset_ptr[index] = int32_t(offset);
+				const char *token_text = whisper_full_get_token_text_from_state(ctx, chunk.state, i, j);
+				if (token_text) {
+					const size_t length = strlen(token_text);
+					memcpy(text_ptr + offset, token_text, length);
+					offset += length;
+				}
+				index++;
+			}
+		}
+	}
+	offset_ptr[n_tokens] = int32_t(offset);
+
+	result["segment"] = segment_index;
+	result["id"] = id;
+	result["p"] = p;
+	result["plog"] = plog;
+	result["t0"] = t0;
+	result["t1"] = t1;
+	result["text"] = text;
+	result["text_offset"] = text_offset;
 	return result;
 }
 
 int WhisperFull::get_detected_lang_id() const {
 	ERR_FAIL_COND_V_MSG(ctx == nullptr, -1, "[WhisperFull] context not initialized");
-	return whisper_full_lang_id(ctx);
+	return whisper_full_lang_id_from_state(state);
 }
 
 String WhisperFull::get_detected_language() const {
@@ -1126,30 +2598,54 @@ String WhisperFull::get_detected_language() const {
 
 /* --- timing information --- */
 
+// timings are measured per instance, since the shared context has no state of its own
 Dictionary WhisperFull::get_timings() const {
 	Dictionary timings;
-	ERR_FAIL_COND_V_MSG(ctx == nullptr, timings, "[WhisperFull] context not initialized");
 
-	whisper_timings *t = whisper_get_timings(ctx);
-	if (t) {
-		timings["sample_ms"] = t->sample_ms;
-		timings["encode_ms"] = t->encode_ms;
-		timings["decode_ms"] = t->decode_ms;
-		timings["batchd_ms"] = t->batchd_ms;
-		timings["prompt_ms"] = t->prompt_ms;
-	}
+	timings["full_ms"] = t_last_us / 1000.0;
+	timings["total_ms"] = t_total_us / 1000.0;
+	timings["n_calls"] = n_calls;
+	timings["audio_ctx"] = last_audio_ctx;
+
+	// whisper_get_timings' encode_ms and decode_ms, from the stage timings of the whisper callbacks
+	timings["encode_ms"] = t_encode_us.get() / 1000.0;
+	timings["decode_ms"] = t_decode_us.get() / 1000.0;
 
 	return timings;
 }
 
 void WhisperFull::print_timings() const {
-	ERR_FAIL_COND_MSG(ctx == nullptr, "[WhisperFull] context not initialized");
-	whisper_print_timings(ctx);
+	UtilityFunctions::print("[WhisperFull] last call: ", String::num(t_last_us / 1000.0, 2), " ms (audio_ctx ", last_audio_ctx, "), total: ", String::num(t_total_us / 1000.0, 2), " ms over ", n_calls, " calls");
+	UtilityFunctions::print("[WhisperFull] encode: ", String::num(t_encode_us.get() / 1000.0, 2), " ms, decode: ", String::num(t_decode_us.get() / 1000.0, 2), " ms");
 }
 
 void WhisperFull::reset_timings() {
-	ERR_FAIL_COND_MSG(ctx == nullptr, "[WhisperFull] context not initialized");
-	whisper_reset_timings(ctx);
+	t_last_us = 0;
+	t_total_us = 0;
+	n_calls = 0;
+	last_audio_ctx = 0;
+	t_encode_us.set(0);
+	t_decode_us.set(0);
+}
+
+Dictionary WhisperFull::get_metrics() const {
+	return metrics.get_dictionary();
+}
+
+void WhisperFull::reset_metrics() {
+	metrics.reset();
+}
+
+void WhisperFull::add_performance_monitors(const String &p_prefix) {
+	metrics.add_monitors(this, p_prefix);
+}
+
+void WhisperFull::remove_performance_monitors() {
+	metrics.remove_monitors();
+}
+
+double WhisperFull::_get_metric(int p_stage, double p_percentile) const {
+	return metrics.get_percentile(p_stage, p_percentile);
 }
 
 /* --- system info --- */
@@ -1168,41 +2664,21 @@ int WhisperFull::get_sample_rate() {
 	return WHISPER_SAMPLE_RATE;
 }
 
-// perform linear interpolation resampling + stereo to mono.
-// btw, this function is just for convenience, you can use your own resampling library if you want.
+// band-limited resampling + stereo to mono, see WhisperResampler.
+// this is a one-shot conversion: streams should keep their own WhisperResampler so the filter state carries across chunks.
 PackedFloat32Array WhisperFull::convert_stereo_to_mono_16khz(int p_from_sample_rate, const PackedVector2Array &p_stereo_data) {
 	PackedFloat32Array result;
 
-	if (p_stereo_data.is_empty()) {
+	if (p_stereo_data.is_empty() || p_from_sample_rate <= 0) {
 		return result;
 	}
 
-	float whisper_sample_rate = WHISPER_SAMPLE_RATE;
-	float ratio = p_from_sample_rate / whisper_sample_rate;
-
-	int output_size = int(p_stereo_data.size() / ratio);
-	if (output_size <= 0) {
-		return result;
-	}
+	WhisperResampler resampler;
+	resampler.setup(p_from_sample_rate);
 
+	result.resize(resampler.get_max_output(p_stereo_data.size()));
+	int output_size = resampler.process_stereo(p_stereo_data.ptr(), p_stereo_data.size(), result.ptrw());
 	result.resize(output_size);
-	float *result_ptr = result.ptrw();
-	const Vector2 *stereo_ptr = p_stereo_data.ptr();
-	int stereo_size = p_stereo_data.size();
-
-	for (int i = 0; i < output_size; i++) {
-		float src_index = float(i) * ratio;
-		int idx0 = int(src_index);
-		int idx1 = MIN(idx0 + 1, stereo_size - 1);
-		float frac = src_index - float(idx0);
-
-		// stereo to mono (average of left and right)
-		float sample0 = (stereo_ptr[idx0].x + stereo_ptr[idx0].y) * 0.5f;
-		float sample1 = (stereo_ptr[idx1].x + stereo_ptr[idx1].y) * 0.5f;
-
-		// linear interpolation
-		result_ptr[i] = sample0 + (sample1 - sample0) * frac;
-	}
 
 	return result;
 }
\ No newline at end of file
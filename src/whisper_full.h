@@ -1,14 +1,35 @@
 #pragma once
 
 #include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/classes/thread.hpp>
+#include <godot_cpp/classes/mutex.hpp>
+#include <godot_cpp/classes/semaphore.hpp>
+#include <godot_cpp/templates/list.hpp>
+#include <godot_cpp/templates/safe_refcount.hpp>
+#include <godot_cpp/variant/packed_byte_array.hpp>
 #include <godot_cpp/variant/packed_float32_array.hpp>
+#include <godot_cpp/variant/packed_int32_array.hpp>
+#include <godot_cpp/variant/packed_int64_array.hpp>
+#include <godot_cpp/variant/packed_string_array.hpp>
 #include <godot_cpp/variant/typed_array.hpp>
 #include <godot_cpp/templates/local_vector.hpp>
 using namespace godot;
 
+#include <atomic>
 #include <cfloat>
 
+#include "mpsc_queue.h"
+#include "whisper_metrics.h"
 #include "whisper_model.h"
+#include "whisper_model_loader.h"
+
+// char data referenced by whisper_full_params, must outlive the whisper_full call
+struct WhisperParamStrings {
+	CharString suppress_regex;
+	CharString initial_prompt;
+	CharString language;
+	CharString vad_model_path;
+};
 
 // this class represents a transcription segment result
 class WhisperSegment : public RefCounted {
@@ -43,12 +64,83 @@ public:
 	~WhisperSegment();
 };
 
+// per-call hooks of the native transcribe methods, run on the thread making the call
+struct WhisperCallHooks {
+	// gets the segments of this call as whisper decodes them, only with stream_signals on
+	void (*segment_callback)(void *p_userdata, const Ref<WhisperSegment> &p_segment) = nullptr;
+	void *userdata = nullptr;
+
+	// aborts only this call once set, unlike cancel() which aborts every call on the instance
+	const SafeFlag *cancel = nullptr;
+};
+
+// this class represents an asynchronous transcription submitted with WhisperFull.transcribe_async
+// it is filled by a worker thread and can be awaited through its "completed" signal or wait()
+class WhisperJob : public RefCounted {
+	GDCLASS(WhisperJob, RefCounted);
+
+	friend class WhisperFull;
+
+public:
+	enum Status {
+		STATUS_PENDING,
+		STATUS_RUNNING,
+		STATUS_COMPLETED,
+		STATUS_FAILED,
+		STATUS_CANCELED,
+	};
+
+private:
+	SafeNumeric<uint32_t> status;
+	Ref<Semaphore> done_sem;
+
+	// input (set on submission, read by the worker)
+	PackedFloat32Array samples;
+	whisper_full_params params;
+	WhisperParamStrings param_strings;
+	uint64_t submit_usec = 0;
+	SafeFlag cancel_requested;
+
+	// output (written by the worker before the job is marked as done)
+	int result = 0;
+	TypedArray<WhisperSegment> segments;
+	String text;
+	float queue_ms = 0.0f;
+	float process_ms = 0.0f;
+	int audio_ctx = 0;
+
+	void _finish(Status p_status);
+
+protected:
+	static void _bind_methods();
+
+public:
+	Status get_status() const;
+	bool is_done() const;
+	void wait();
+
+	// a queued job is dropped, a running one is aborted at the next whisper callback
+	void cancel();
+
+	int get_result() const;
+	TypedArray<WhisperSegment> get_segments() const;
+	String get_text() const;
+
+	float get_queue_ms() const;
+	float get_process_ms() const;
+	int get_audio_ctx() const;
+
+	WhisperJob();
+	~WhisperJob();
+};
+
 // this class represents the function "whisper_full" from whisper.cpp.
 class WhisperFull : public RefCounted {
 	GDCLASS(WhisperFull, RefCounted);
 
 	Ref<WhisperModel> model;
-	whisper_context *ctx = nullptr;
+	whisper_context *ctx = nullptr; // shared between instances through WhisperContextCache
+	whisper_state *state = nullptr; // owned by this instance
 
 	// context parameters
 	bool use_gpu = true;
@@ -77,6 +169,8 @@ class WhisperFull : public RefCounted {
 	int max_tokens = 0;
 	bool debug_mode = false;
 	int audio_ctx = 0;
+	bool audio_ctx_auto = false;
+	int audio_ctx_margin_ms = 500;
 	bool tdrz_enable = false;
 	String suppress_regex;
 	String initial_prompt;
@@ -111,15 +205,148 @@ class WhisperFull : public RefCounted {
 	float vad_samples_overlap = 0.1f;
 
 	// internal - stores char data for whisper API
-	CharString suppress_regex_cs;
-	CharString initial_prompt_cs;
-	CharString language_cs;
-	CharString vad_model_path_cs;
+	WhisperParamStrings param_strings;
+
+	// results of the last transcription, split by the state holding them
+	struct ResultChunk {
+		whisper_state *state = nullptr;
+		int64_t t_offset = 0; // in centiseconds
+		int n_segments = 0;
+	};
+	LocalVector<ResultChunk> result_chunks;
+	int result_segment_count = 0;
+
+	// per-call data handed to the whisper callbacks
+	struct CallbackData {
+		WhisperFull *self = nullptr;
+		WhisperJob *job = nullptr;
+		int64_t t_offset = 0; // in centiseconds
+		int last_progress = -1;
+		uint32_t cancel_generation = 0; // the call is aborted once cancel() moves past this
+		const WhisperCallHooks *hooks = nullptr; // or once the caller's own cancel flag is set
+		uint64_t deadline_usec = 0; // 0 means no deadline
+		bool aborted = false;
+
+		// stage timing, the encoder callback starts each window's encode and the first logits of a window
+		// start its decode (whisper.cpp keeps per-state timings to itself). the encode therefore also covers
+		// the decode of the prompt, which runs before the first token is sampled. with beam search or
+		// best_of > 1 the logits of several decoders are processed on parallel threads, hence the atomics
+		uint64_t t_call_usec = 0;
+		std::atomic<uint64_t> t_encode_usec{ 0 }; // encoding since, 0 while not encoding
+		std::atomic<uint64_t> t_decode_usec{ 0 }; // decoding since, 0 while not decoding
+		uint64_t mel_usec = 0;
+		std::atomic<uint64_t> encode_usec{ 0 };
+		uint64_t decode_usec = 0;
+		bool encoder_started = false;
+	};
+
+	// parallel transcription (one extra state per additional processor)
+	bool parallel_split_on_silence = true;
+	int parallel_split_search_ms = 5000;
+	LocalVector<whisper_state *> parallel_states;
+	LocalVector<int> parallel_offsets;
+	LocalVector<int> parallel_results;
+	whisper_full_params parallel_params;
+	const float *parallel_samples = nullptr;
+	CallbackData parallel_call;
+	LocalVector<uint8_t> parallel_aborted;
+
+	// batched transcription, one window per state
+	LocalVector<whisper_state *> batch_states;
+	LocalVector<Ref<WhisperJob>> batch_jobs;
+
+	// async initialization
+	Ref<Thread> init_thread;
+	Ref<Mutex> init_mtx;
+	SafeFlag initialized;
+	SafeFlag load_canceled; // set while the context is freed, loads in progress give up
+	WhisperLoadProgress init_progress;
+	int init_progress_percent = -1;
+	int init_id = 0; // bumped when a load is canceled, its deferred result is dropped
+
+	// cancellation
+	int max_decode_ms = 0;
+	SafeNumeric<uint32_t> cancel_generation;
+	bool last_canceled = false;
+
+	// streaming results, pushed from the whisper callbacks and emitted on the main thread
+	struct StreamEvent {
+		Ref<WhisperJob> job; // events of async jobs are emitted on the job itself
+		Ref<WhisperSegment> segment; // null for progress events
+		int progress = 0;
+	};
+	bool stream_signals = false;
+	MPSCQueue<StreamEvent> stream_events;
+	std::atomic<bool> stream_flush_queued{ false };
+
+	// async job pool, each worker owns a whisper_state
+	int n_workers = 1;
+	LocalVector<Ref<Thread>> worker_threads;
+	LocalVector<whisper_state *> worker_states;
+	List<Ref<WhisperJob>> job_queue;
+	List<Ref<WhisperJob>> finished_jobs; // waiting for their signals on the main thread
+	Ref<Mutex> job_mtx;
+	Ref<Semaphore> job_sem;
+	SafeFlag workers_stop;
+
+	// per-stage histograms, recorded by every call on any state
+	enum MetricStage {
+		METRIC_QUEUE,
+		METRIC_MEL,
+		METRIC_ENCODE,
+		METRIC_DECODE,
+		METRIC_TOTAL,
+		METRIC_RTF,
+	};
+	WhisperMetrics metrics;
+
+	// timings (whisper_get_timings only covers the context's own state)
+	uint64_t t_last_us = 0;
+	uint64_t t_total_us = 0;
+	int n_calls = 0;
+	SafeNumeric<uint64_t> t_encode_us; // every call on this instance, async jobs and batch windows included
+	SafeNumeric<uint64_t> t_decode_us;
+	int last_audio_ctx = 0;
 
 	// internal
 	bool _init_context();
+	bool _load_context(WhisperLoadProgress *p_progress);
 	void _free_context();
-	whisper_full_params _build_params();
+	void _cancel_init_async();
+	void _init_thread_func(int p_init_id);
+	void _finish_init_async(bool p_success, int p_init_id);
+	static void _on_load_progress(void *p_userdata, uint64_t p_bytes_loaded, uint64_t p_bytes_total);
+	void _start_workers();
+	void _stop_workers();
+	void _resume_workers();
+	void _job_worker_func(int p_index);
+	void _run_job(const Ref<WhisperJob> &p_job, whisper_state *p_state);
+	void _queue_finished_job(const Ref<WhisperJob> &p_job);
+	void _emit_finished_jobs();
+	void _begin_call(CallbackData &r_data) const;
+	static void _start_timing(CallbackData &r_data);
+	void _end_call(CallbackData &r_data, int p_n_samples);
+	double _get_metric(int p_stage, double p_percentile) const;
+	static void _on_logits_filter(whisper_context *p_ctx, whisper_state *p_state, const whisper_token_data *p_tokens, int p_n_tokens, float *p_logits, void *p_user_data);
+	void _set_callbacks(whisper_full_params &r_params, CallbackData *p_data, bool p_report_progress) const;
+	static bool _should_abort(CallbackData *p_data);
+	static bool _on_abort(void *p_user_data);
+	static bool _on_encoder_begin(whisper_context *p_ctx, whisper_state *p_state, void *p_user_data);
+	void _queue_stream_event(const StreamEvent &p_event);
+	void _flush_stream_events();
+	static void _on_new_segment(whisper_context *p_ctx, whisper_state *p_state, int p_n_new, void *p_user_data);
+	static void _on_progress(whisper_context *p_ctx, whisper_state *p_state, int p_progress, void *p_user_data);
+	whisper_full_params _build_params(WhisperParamStrings &r_strings);
+	Ref<WhisperSegment> _make_segment(whisper_state *p_state, int p_index, int64_t p_t_offset) const;
+	whisper_state *_get_parallel_state(int p_index) const;
+	int _find_parallel_split(const float *p_samples, int p_from, int p_to, int p_target) const;
+	void _parallel_chunk_task(int p_index);
+	void _batch_task(int p_index);
+	void _set_single_result(whisper_state *p_state);
+	whisper_state *_resolve_segment(int p_index, int &r_local_index, int64_t &r_t_offset) const;
+	static String _join_segment_texts(const ResultChunk *p_chunks, int p_n_chunks);
+	void _record_timing(uint64_t p_start_usec);
+	void _apply_audio_ctx(whisper_full_params &r_params, int p_n_samples) const;
 
 protected:
 	static void _bind_methods();
@@ -155,6 +382,15 @@ public:
 	void set_n_max_text_ctx(int p_n_max_text_ctx);
 	int get_n_max_text_ctx() const;
 
+	void set_n_workers(int p_n_workers);
+	int get_n_workers() const;
+
+	void set_parallel_split_on_silence(bool p_parallel_split_on_silence);
+	bool get_parallel_split_on_silence() const;
+
+	void set_parallel_split_search_ms(int p_parallel_split_search_ms);
+	int get_parallel_split_search_ms() const;
+
 	// full params - timing
 	void set_offset_ms(int p_offset_ms);
 	int get_offset_ms() const;
@@ -213,12 +449,27 @@ public:
 	void set_audio_ctx(int p_audio_ctx);
 	int get_audio_ctx() const;
 
+	// picks the smallest audio_ctx covering each call's audio (plus the margin) instead of audio_ctx
+	void set_audio_ctx_auto(bool p_audio_ctx_auto);
+	bool get_audio_ctx_auto() const;
+
+	void set_audio_ctx_margin_ms(int p_audio_ctx_margin_ms);
+	int get_audio_ctx_margin_ms() const;
+
 	void set_tdrz_enable(bool p_tdrz_enable);
 	bool get_tdrz_enable() const;
 
 	void set_suppress_regex(const String &p_suppress_regex);
 	String get_suppress_regex() const;
 
+	// cancellation - 0 disables the deadline
+	void set_max_decode_ms(int p_max_decode_ms);
+	int get_max_decode_ms() const;
+
+	// streaming - emit "segment_ready" / "progress" while whisper_full is still running, off by default
+	void set_stream_signals(bool p_stream_signals);
+	bool get_stream_signals() const;
+
 	// full params - prompt
 	void set_initial_prompt(const String &p_initial_prompt);
 	String get_initial_prompt() const;
@@ -301,8 +552,14 @@ public:
 	// context management
 	bool is_initialized() const;
 	bool init();
+	// queued async jobs stay queued until the next transcribe_async
 	void free_context();
 
+	// loads the model on a worker thread, emits "initialized" or "init_failed" when done.
+	// free_context and context parameter changes cancel the load, which then fails
+	bool init_async();
+	bool is_loading() const;
+
 	// model info (requires initialized context)
 	bool is_multilingual() const;
 	int get_model_n_vocab() const;
@@ -331,9 +588,36 @@ public:
 	// transcription methods
 	// transcribe from PCM float32 samples (must be 16kHz mono)
 	int transcribe(const PackedFloat32Array &p_samples);
+	int transcribe_native(const float *p_samples, int p_n_samples, const WhisperCallHooks *p_hooks = nullptr);
+
+	// transcribe from a precomputed log-mel spectrogram (get_model_n_mels() x n_len, see WhisperMelSpectrogram)
+	// of p_n_samples samples of audio. whisper's own VAD needs the samples and is skipped
+	int transcribe_mel(const PackedFloat32Array &p_mel, int p_n_samples);
+	int transcribe_mel_native(const float *p_mel, int p_n_len, int p_n_samples, const WhisperCallHooks *p_hooks = nullptr);
+
+	// transcribe an audio file (.wav, .ogg, .mp3) in 30s windows without loading it whole.
+	// segments are only delivered through "segment_ready" (call it from a Thread to receive them while it runs),
+	// afterwards get_segment only covers the last window
+	int transcribe_file(const String &p_path);
+
+	// transcribe from PCM float32 samples with parallel processing.
+	// chunks are cut at pauses near equal splits and stitched with global timestamps,
+	// n_processors <= 0 picks as many chunks as the cores can run with n_threads each
+	int transcribe_parallel(const PackedFloat32Array &p_samples, int p_n_processors = 0);
 
-	// transcribe from PCM float32 samples with parallel processing
-	int transcribe_parallel(const PackedFloat32Array &p_samples, int p_n_processors);
+	// transcribe several windows at once, each on its own state with a share of n_threads.
+	// blocks until all are done, the returned jobs are already completed and emit neither
+	// "completed" nor "job_completed". get_segment and friends don't cover them
+	TypedArray<WhisperJob> transcribe_batch(const TypedArray<PackedFloat32Array> &p_windows);
+
+	// queue a transcription on the worker pool, "job_completed" is emitted on the main thread when done.
+	// jobs left when the instance is freed are canceled and only emit their own "completed"
+	Ref<WhisperJob> transcribe_async(const PackedFloat32Array &p_samples);
+	int get_pending_job_count() const;
+
+	// aborts every transcription in flight on this instance and cancels queued jobs
+	void cancel();
+	bool was_canceled() const;
 
 	// get transcription results
 	int get_segment_count() const;
@@ -342,15 +626,36 @@ public:
 	TypedArray<WhisperSegment> get_all_segments() const;
 	String get_full_text() const;
 
+	// the same results as arrays, without an object per segment: { t0, t1, no_speech_prob, speaker_turn_next, text }
+	Dictionary get_segments_packed() const;
+	// fills caller-owned arrays, which keep their allocation when the segment count doesn't grow
+	int get_segments_packed_native(PackedInt64Array &r_t0, PackedInt64Array &r_t1, PackedFloat32Array &r_no_speech_prob, PackedByteArray &r_speaker_turn_next, PackedStringArray &r_text) const;
+
+	// every token of every segment: { segment, id, p, plog, t0, t1, text, text_offset }.
+	// text is the utf8 of all tokens back to back (a token can end inside a character), token i is
+	// text[text_offset[i] .. text_offset[i + 1]]. t0/t1 are in ms and need token_timestamps, -1 otherwise
+	Dictionary get_tokens_packed(bool p_include_special = false) const;
+
 	// get detected language (after transcription with detect_language enabled)
 	int get_detected_lang_id() const;
 	String get_detected_language() const;
 
-	// timing information
+	// timing information: full_ms (last call), total_ms, n_calls and audio_ctx of this instance's calls,
+	// plus encode_ms and decode_ms summed over them.
+	// compat: sample_ms, batchd_ms and prompt_ms are no longer reported. whisper.cpp only keeps them
+	// on the context's own state, which shared contexts don't have
 	Dictionary get_timings() const;
 	void print_timings() const;
 	void reset_timings();
 
+	// p50/p95/p99 of queue wait, mel, encode, decode, total (ms) and realtime factor
+	Dictionary get_metrics() const;
+	void reset_metrics();
+
+	// shows the same percentiles in the debugger's monitors as "<prefix>/<stage> pXX"
+	void add_performance_monitors(const String &p_prefix = "Whisper");
+	void remove_performance_monitors();
+
 	// system info
 	static String get_system_info();
 	static String get_version();
@@ -362,4 +667,5 @@ public:
 	~WhisperFull();
 };
 
+VARIANT_ENUM_CAST(WhisperJob::Status);
 VARIANT_ENUM_CAST(WhisperFull::Strategy);
\ No newline at end of file
@@ -0,0 +1,265 @@
+#include "whisper_mel_spectrogram.h"
+
+#include <godot_cpp/core/error_macros.hpp>
+#include <godot_cpp/core/math.hpp>
+using namespace godot;
+
+#include <cmath>
+#include <cstring>
+
+// value of a frame whisper.cpp doesn't transform, log10(1e-10)
+static const float MEL_EMPTY = -10.0f;
+
+// slaney mel scale, as used by librosa for whisper's filters
+static double _hz_to_mel(double p_hz) {
+	const double log_step = std::log(6.4) / 27.0;
+	return p_hz >= 1000.0 ? 15.0 + std::log(p_hz / 1000.0) / log_step : p_hz * 3.0 / 200.0;
+}
+
+static double _mel_to_hz(double p_mel) {
+	const double log_step = std::log(6.4) / 27.0;
+	return p_mel >= 15.0 ? 1000.0 * std::exp(log_step * (p_mel - 15.0)) : p_mel * 200.0 / 3.0;
+}
+
+/* --- WhisperMelSpectrogram implementation --- */
+
+void WhisperMelSpectrogram::setup(int p_n_mels) {
+	ERR_FAIL_COND_MSG(p_n_mels <= 0, "[WhisperMelSpectrogram] n_mels must be positive");
+
+	n_mels = p_n_mels;
+
+	// periodic hann window and the fft twiddles
+	for (int i = 0; i < FRAME_SIZE; i++) {
+		hann[i] = float(0.5 * (1.0 - std::cos(Math_TAU * i / FRAME_SIZE)));
+		sin_vals[i] = float(std::sin(Math_TAU * i / FRAME_SIZE));
+		cos_vals[i] = float(std::cos(Math_TAU * i / FRAME_SIZE));
+	}
+
+	// triangular filters between n_mels + 2 points spread evenly on the mel scale up to nyquist,
+	// area normalized (librosa's norm="slaney"), the same matrix whisper models ship with
+	const double mel_max = _hz_to_mel(WHISPER_SAMPLE_RATE / 2.0);
+	LocalVector<double> points;
+	points.resize(n_mels + 2);
+	for (int i = 0; i < n_mels + 2; i++) {
+		points[i] = _mel_to_hz(mel_max * i / (n_mels + 1));
+	}
+
+	edge_mel.resize(n_mels);
+	filters.resize(n_mels * N_BINS);
+	for (int m = 0; m < n_mels; m++) {
+		const double norm = 2.0 / (points[m + 2] - points[m]);
+		for (int k = 0; k < N_BINS; k++) {
+			const double hz = double(k) * WHISPER_SAMPLE_RATE / FRAME_SIZE;
+			const double lower = (hz - points[m]) / (points[m + 1] - points[m]);
+			const double upper = (points[m + 2] - hz) / (points[m + 2] - points[m + 1]);
+			filters[m * N_BINS + k] = float(MAX(0.0, MIN(lower, upper)) * norm);
+		}
+	}
+
+	reset();
+}
+
+void WhisperMelSpectrogram::reset() {
+	samples.clear();
+	samples_start = 0;
+	frames.clear();
+	frames_start = 0;
+	frames_end = 0;
+}
+
+// used for the odd sizes left after halving (400 -> 25)
+void WhisperMelSpectrogram::_dft(const float *p_in, int p_n, float *r_out) {
+	const int step = FRAME_SIZE / p_n;
+	for (int k = 0; k < p_n; k++) {
+		float re = 0.0f;
+		float im = 0.0f;
+		for (int n = 0; n < p_n; n++) {
+			int index = (k * n * step) % FRAME_SIZE;
+			re += p_in[n] * cos_vals[index];
+			im -= p_in[n] * sin_vals[index];
+		}
+		r_out[k * 2 + 0] = re;
+		r_out[k * 2 + 1] = im;
+	}
+}
+
+// radix-2 cooley-tukey, p_in needs room for 2 * p_n and r_out for 8 * p_n floats as scratch
+void WhisperMelSpectrogram::_fft(float *p_in, int p_n, float *r_out) {
+	if (p_n == 1) {
+		r_out[0] = p_in[0];
+		r_out[1] = 0.0f;
+		return;
+	}
+
+	const int half_n = p_n / 2;
+	if (p_n - half_n * 2 == 1) {
+		_dft(p_in, p_n, r_out);
+		return;
+	}
+
+	float *even = p_in + p_n;
+	for (int i = 0; i < half_n; i++) {
+		even[i] = p_in[i * 2];
+	}
+	float *even_fft = r_out + p_n * 2;
+	_fft(even, half_n, even_fft);
+
+	float *odd = even;
+	for (int i = 0; i < half_n; i++) {
+		odd[i] = p_in[i * 2 + 1];
+	}
+	float *odd_fft = even_fft + p_n;
+	_fft(odd, half_n, odd_fft);
+
+	const int step = FRAME_SIZE / p_n;
+	for (int k = 0; k < half_n; k++) {
+		const float re = cos_vals[k * step];
+		const float im = -sin_vals[k * step];
+		const float re_odd = odd_fft[k * 2 + 0];
+		const float im_odd = odd_fft[k * 2 + 1];
+
+		r_out[k * 2 + 0] = even_fft[k * 2 + 0] + re * re_odd - im * im_odd;
+		r_out[k * 2 + 1] = even_fft[k * 2 + 1] + re * im_odd + im * re_odd;
+		r_out[(k + half_n) * 2 + 0] = even_fft[k * 2 + 0] - re * re_odd + im * im_odd;
+		r_out[(k + half_n) * 2 + 1] = even_fft[k * 2 + 1] - re * im_odd - im * re_odd;
+	}
+}
+
+// one frame of FRAME_SIZE samples to n_mels log10 energies
+void WhisperMelSpectrogram::_compute_frame(const float *p_frame, float *r_mel) {
+	for (int i = 0; i < FRAME_SIZE; i++) {
+		fft_in[i] = hann[i] * p_frame[i];
+	}
+	_fft(fft_in, FRAME_SIZE, fft_out);
+
+	// power spectrum, in place
+	for (int k = 0; k < N_BINS; k++) {
+		fft_out[k] = fft_out[k * 2 + 0] * fft_out[k * 2 + 0] + fft_out[k * 2 + 1] * fft_out[k * 2 + 1];
+	}
+
+	for (int m = 0; m < n_mels; m++) {
+		const float *filter = filters.ptr() + m * N_BINS;
+		double sum = 0.0;
+		for (int k = 0; k < N_BINS; k++) {
+			sum += filter[k] * fft_out[k];
+		}
+		r_mel[m] = float(std::log10(MAX(sum, 1e-10)));
+	}
+}
+
+void WhisperMelSpectrogram::append(const float *p_samples, int p_count) {
+	ERR_FAIL_COND_MSG(n_mels == 0, "[WhisperMelSpectrogram] setup() was not called");
+	if (p_count <= 0) {
+		return;
+	}
+
+	uint32_t offset = samples.size();
+	samples.resize(offset + p_count);
+	memcpy(samples.ptr() + offset, p_samples, p_count * sizeof(float));
+
+	// every frame whose samples are all here is computed once, frames reaching before the buffered
+	// audio can't be and are left to build()
+	const int64_t end = get_end();
+	while (frames_end * FRAME_STEP + FRAME_SIZE / 2 <= end) {
+		const int64_t frame_from = frames_end * FRAME_STEP - FRAME_SIZE / 2;
+		if (frame_from < samples_start) {
+			frames_end++;
+			frames_start = frames_end;
+			frames.clear();
+			continue;
+		}
+
+		uint32_t frame_offset = frames.size();
+		frames.resize(frame_offset + n_mels);
+		_compute_frame(samples.ptr() + (frame_from - samples_start), frames.ptr() + frame_offset);
+		frames_end++;
+	}
+}
+
+void WhisperMelSpectrogram::discard_before(int64_t p_sample) {
+	p_sample = CLAMP(p_sample, samples_start, get_end());
+
+	int drop = int(p_sample - samples_start);
+	if (drop > 0) {
+		memmove(samples.ptr(), samples.ptr() + drop, (samples.size() - drop) * sizeof(float));
+		samples.resize(samples.size() - drop);
+		samples_start = p_sample;
+	}
+
+	// frames reaching before p_sample differ from the ones a window starting there gets
+	const int64_t first_frame = (p_sample + FRAME_SIZE / 2 + FRAME_STEP - 1) / FRAME_STEP;
+	if (first_frame > frames_start) {
+		int drop_frames = int(MIN(first_frame, frames_end) - frames_start);
+		memmove(frames.ptr(), frames.ptr() + drop_frames * n_mels, (frames.size() - drop_frames * n_mels) * sizeof(float));
+		frames.resize(frames.size() - drop_frames * n_mels);
+		frames_start = first_frame;
+		frames_end = MAX(frames_end, frames_start);
+	}
+}
+
+int WhisperMelSpectrogram::build(int64_t p_start, LocalVector<float> &r_mel) {
+	ERR_FAIL_COND_V_MSG(n_mels == 0, 0, "[WhisperMelSpectrogram] setup() was not called");
+	if (p_start % FRAME_STEP != 0 || p_start < samples_start) {
+		return 0;
+	}
+
+	const float *window = samples.ptr() + (p_start - samples_start);
+	const int n_samples = int(get_end() - p_start);
+	if (n_samples <= FRAME_SIZE / 2) {
+		return 0;
+	}
+
+	// whisper.cpp pads 30s of silence after the audio, frames that only see the padding are left empty
+	const int n_len = (n_samples + WHISPER_SAMPLE_RATE * WHISPER_CHUNK_SIZE) / FRAME_STEP;
+	const int n_computed = MIN((n_samples + FRAME_SIZE / 2) / FRAME_STEP + 1, n_len);
+	const int64_t first_frame = p_start / FRAME_STEP;
+
+	r_mel.resize(n_mels * n_len);
+	float *mel = r_mel.ptr();
+
+	float frame[FRAME_SIZE];
+	float *frame_mel = edge_mel.ptr();
+
+	for (int f = 0; f < n_computed; f++) {
+		const int frame_from = f * FRAME_STEP - FRAME_SIZE / 2;
+		const int64_t t = first_frame + f;
+
+		const float *values = nullptr;
+		if (frame_from >= 0 && frame_from + FRAME_SIZE <= n_samples && t >= frames_start && t < frames_end) {
+			values = frames.ptr() + (t - frames_start) * n_mels;
+		} else {
+			// the edges: reflected at the start, zero padded at the end
+			for (int j = 0; j < FRAME_SIZE; j++) {
+				int s = frame_from + j;
+				if (s < 0) {
+					s = -s;
+				}
+				frame[j] = s < n_samples ? window[s] : 0.0f;
+			}
+			_compute_frame(frame, frame_mel);
+			values = frame_mel;
+		}
+
+		for (int m = 0; m < n_mels; m++) {
+			mel[m * n_len + f] = values[m];
+		}
+	}
+
+	for (int m = 0; m < n_mels; m++) {
+		for (int f = n_computed; f < n_len; f++) {
+			mel[m * n_len + f] = MEL_EMPTY;
+		}
+	}
+
+	// clamp to 8 below the loudest value, then scale like whisper.cpp
+	float mel_max = -1e20f;
+	for (int i = 0; i < n_mels * n_len; i++) {
+		mel_max = MAX(mel_max, mel[i]);
+	}
+	mel_max -= 8.0f;
+	for (int i = 0; i < n_mels * n_len; i++) {
+		mel[i] = (MAX(mel[i], mel_max) + 4.0f) / 4.0f;
+	}
+
+	return n_len;
+}
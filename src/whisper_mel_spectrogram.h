@@ -0,0 +1,55 @@
+#pragma once
+
+#include <godot_cpp/templates/local_vector.hpp>
+using namespace godot;
+
+#include <whisper.h>
+
+// this class computes whisper's log-mel input for a continuous 16kHz stream, reusing frames between windows.
+// it follows whisper.cpp's front-end (hann window, 400 point FFT, slaney mel filters, log10, clamp to max - 8),
+// but keeps the log10 frames of the appended audio, so a window overlapping the previous one only runs the
+// FFT for the new audio and the few frames at its edges. the result is handed to WhisperFull.transcribe_mel
+class WhisperMelSpectrogram {
+	static const int FRAME_SIZE = WHISPER_N_FFT;
+	static const int FRAME_STEP = WHISPER_HOP_LENGTH;
+	static const int N_BINS = WHISPER_N_FFT / 2 + 1;
+
+	int n_mels = 0;
+	LocalVector<float> filters; // n_mels * N_BINS
+	float hann[FRAME_SIZE];
+	float sin_vals[FRAME_SIZE];
+	float cos_vals[FRAME_SIZE];
+
+	// scratch for the recursive fft, the sizes whisper.cpp uses
+	float fft_in[FRAME_SIZE * 2];
+	float fft_out[FRAME_SIZE * 8];
+	LocalVector<float> edge_mel; // frames computed by build(), not cached
+
+	// rolling cache, indices are absolute since the last reset.
+	// frame t is centered on sample t * FRAME_STEP and only cached once all of its samples arrived
+	LocalVector<float> samples;
+	int64_t samples_start = 0;
+	LocalVector<float> frames; // log10 values, frame major
+	int64_t frames_start = 0;
+	int64_t frames_end = 0;
+
+	void _fft(float *p_in, int p_n, float *r_out);
+	void _dft(const float *p_in, int p_n, float *r_out);
+	void _compute_frame(const float *p_frame, float *r_mel);
+
+public:
+	void setup(int p_n_mels);
+	int get_n_mels() const { return n_mels; }
+
+	void reset();
+	void append(const float *p_samples, int p_count);
+	int64_t get_end() const { return samples_start + samples.size(); }
+
+	// drops the audio and frames no window starting at p_sample can use
+	void discard_before(int64_t p_sample);
+
+	// builds the normalized mel of the window from p_start to the end of the appended audio, laid out
+	// n_mels x n_len like whisper_set_mel expects. returns n_len, or 0 if p_start is not on a frame step
+	// or no longer buffered
+	int build(int64_t p_start, LocalVector<float> &r_mel);
+};
@@ -0,0 +1,158 @@
+#include "whisper_metrics.h"
+
+#include <godot_cpp/classes/performance.hpp>
+#include <godot_cpp/core/error_macros.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/callable.hpp>
+using namespace godot;
+
+/* --- WhisperHistogram implementation --- */
+
+WhisperHistogram::WhisperHistogram() {
+	reset();
+}
+
+int WhisperHistogram::_get_bucket(uint64_t p_value) {
+	if (p_value < SUB_BUCKETS) {
+		return int(p_value);
+	}
+
+	p_value = MIN(p_value, (uint64_t(1) << (MAX_BITS + 1)) - 1);
+
+	int msb = 0;
+	for (uint64_t v = p_value >> 1; v != 0; v >>= 1) {
+		msb++;
+	}
+
+	// the top bits below the most significant one pick the sub bucket
+	int sub = int(p_value >> (msb - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+	return (msb - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+// middle of the values a bucket holds
+uint64_t WhisperHistogram::_get_bucket_value(int p_bucket) {
+	if (p_bucket < SUB_BUCKETS) {
+		return p_bucket;
+	}
+
+	int msb = p_bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+	int sub = p_bucket % SUB_BUCKETS;
+	uint64_t width = uint64_t(1) << (msb - SUB_BUCKET_BITS);
+	return (SUB_BUCKETS + sub) * width + width / 2;
+}
+
+void WhisperHistogram::record(uint64_t p_value) {
+	buckets[_get_bucket(p_value)].fetch_add(1, std::memory_order_relaxed);
+	count.fetch_add(1, std::memory_order_relaxed);
+	sum.fetch_add(p_value, std::memory_order_relaxed);
+	last.store(p_value, std::memory_order_relaxed);
+
+	uint64_t current_max = max_value.load(std::memory_order_relaxed);
+	while (p_value > current_max && !max_value.compare_exchange_weak(current_max, p_value, std::memory_order_relaxed)) {
+	}
+}
+
+void WhisperHistogram::reset() {
+	for (int i = 0; i < N_BUCKETS; i++) {
+		buckets[i].store(0, std::memory_order_relaxed);
+	}
+	count.store(0, std::memory_order_relaxed);
+	sum.store(0, std::memory_order_relaxed);
+	max_value.store(0, std::memory_order_relaxed);
+	last.store(0, std::memory_order_relaxed);
+}
+
+double WhisperHistogram::get_mean() const {
+	uint64_t n = count.load(std::memory_order_relaxed);
+	return n > 0 ? double(sum.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+// buckets are read while other threads record, the result is approximate like the buckets themselves
+uint64_t WhisperHistogram::get_percentile(double p_percentile) const {
+	uint64_t n = count.load(std::memory_order_relaxed);
+	if (n == 0) {
+		return 0;
+	}
+
+	uint64_t rank = uint64_t(CLAMP(p_percentile, 0.0, 1.0) * n);
+	uint64_t seen = 0;
+	for (int i = 0; i < N_BUCKETS; i++) {
+		seen += buckets[i].load(std::memory_order_relaxed);
+		if (seen > rank) {
+			return MIN(_get_bucket_value(i), get_max());
+		}
+	}
+	return get_max();
+}
+
+/* --- WhisperMetrics implementation --- */
+
+int WhisperMetrics::add_stage(const char *p_name) {
+	ERR_FAIL_COND_V_MSG(n_stages >= MAX_STAGES, 0, "[WhisperMetrics] too many stages");
+	names[n_stages] = p_name;
+	return n_stages++;
+}
+
+void WhisperMetrics::reset() {
+	for (int i = 0; i < n_stages; i++) {
+		histograms[i].reset();
+	}
+}
+
+double WhisperMetrics::get_percentile(int p_stage, double p_percentile) const {
+	ERR_FAIL_INDEX_V(p_stage, n_stages, 0.0);
+	return histograms[p_stage].get_percentile(p_percentile) / 1000.0;
+}
+
+Dictionary WhisperMetrics::get_dictionary() const {
+	Dictionary result;
+	for (int i = 0; i < n_stages; i++) {
+		const WhisperHistogram &histogram = histograms[i];
+
+		Dictionary stage;
+		stage["count"] = (int64_t)histogram.get_count();
+		stage["last"] = histogram.get_last() / 1000.0;
+		stage["mean"] = histogram.get_mean() / 1000.0;
+		stage["p50"] = histogram.get_percentile(0.50) / 1000.0;
+		stage["p95"] = histogram.get_percentile(0.95) / 1000.0;
+		stage["p99"] = histogram.get_percentile(0.99) / 1000.0;
+		stage["max"] = histogram.get_max() / 1000.0;
+		result[names[i]] = stage;
+	}
+	return result;
+}
+
+void WhisperMetrics::add_monitors(Object *p_owner, const String &p_prefix) {
+	remove_monitors();
+
+	Performance *performance = Performance::get_singleton();
+	const double percentiles[3] = { 0.50, 0.95, 0.99 };
+	const char *labels[3] = { "p50", "p95", "p99" };
+
+	for (int i = 0; i < n_stages; i++) {
+		for (int j = 0; j < 3; j++) {
+			String id = p_prefix + "/" + names[i] + " " + labels[j];
+			if (performance->has_custom_monitor(id)) {
+				ERR_PRINT("[WhisperMetrics] performance monitor already exists: " + id);
+				continue;
+			}
+			performance->add_custom_monitor(id, Callable(p_owner, "_get_metric").bind(i, percentiles[j]));
+			monitors.push_back(id);
+		}
+	}
+}
+
+void WhisperMetrics::remove_monitors() {
+	Performance *performance = Performance::get_singleton();
+	if (performance == nullptr) {
+		monitors.clear();
+		return;
+	}
+
+	for (int i = 0; i < monitors.size(); i++) {
+		if (performance->has_custom_monitor(monitors[i])) {
+			performance->remove_custom_monitor(monitors[i]);
+		}
+	}
+	monitors.clear();
+}
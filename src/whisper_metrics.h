@@ -0,0 +1,69 @@
+#pragma once
+
+#include <godot_cpp/core/object.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/packed_string_array.hpp>
+#include <godot_cpp/variant/string.hpp>
+using namespace godot;
+
+#include <atomic>
+
+// this class is a lock-free histogram for latencies recorded from any thread.
+// buckets are log-linear (8 per power of two, within 12.5% of the value), so recording is one
+// relaxed increment and percentiles are read by walking the buckets.
+// values are integers in thousandths of the reported unit: microseconds for milliseconds
+class WhisperHistogram {
+	static const int SUB_BUCKETS = 8;
+	static const int SUB_BUCKET_BITS = 3;
+	static const int MAX_BITS = 40; // ~12 days in microseconds
+	static const int N_BUCKETS = (MAX_BITS - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+	std::atomic<uint32_t> buckets[N_BUCKETS];
+	std::atomic<uint64_t> count{ 0 };
+	std::atomic<uint64_t> sum{ 0 };
+	std::atomic<uint64_t> max_value{ 0 };
+	std::atomic<uint64_t> last{ 0 };
+
+	static int _get_bucket(uint64_t p_value);
+	static uint64_t _get_bucket_value(int p_bucket);
+
+public:
+	void record(uint64_t p_value);
+	void reset();
+
+	uint64_t get_count() const { return count.load(std::memory_order_relaxed); }
+	uint64_t get_last() const { return last.load(std::memory_order_relaxed); }
+	uint64_t get_max() const { return max_value.load(std::memory_order_relaxed); }
+	double get_mean() const;
+	uint64_t get_percentile(double p_percentile) const;
+
+	WhisperHistogram();
+};
+
+// this class groups the histograms of the stages an object times,
+// and exposes them as a Dictionary and as custom monitors of the Performance singleton
+class WhisperMetrics {
+	static const int MAX_STAGES = 12;
+
+	const char *names[MAX_STAGES];
+	WhisperHistogram histograms[MAX_STAGES];
+	int n_stages = 0;
+
+	PackedStringArray monitors;
+
+public:
+	// stages are added once, in the owner's constructor
+	int add_stage(const char *p_name);
+	const char *get_stage_name(int p_stage) const { return names[p_stage]; }
+
+	void record(int p_stage, uint64_t p_value) { histograms[p_stage].record(p_value); }
+	void reset();
+
+	// { stage: { count, last, mean, p50, p95, p99, max } }, durations in ms
+	Dictionary get_dictionary() const;
+	double get_percentile(int p_stage, double p_percentile) const;
+
+	// p50/p95/p99 of every stage as "<prefix>/<stage> pXX", p_owner must bind _get_metric(stage, percentile)
+	void add_monitors(Object *p_owner, const String &p_prefix);
+	void remove_monitors();
+};
@@ -5,18 +5,33 @@
 #include <godot_cpp/variant/callable.hpp>
 #include <godot_cpp/classes/engine.hpp>
 #include <godot_cpp/classes/os.hpp>
+#include <godot_cpp/classes/time.hpp>
 #include <godot_cpp/classes/audio_server.hpp>
 using namespace godot;
 
+#include <cstring>
+
 /* --- WhisperMicrophoneTranscriber implementation --- */
 
 WhisperMicrophoneTranscriber::WhisperMicrophoneTranscriber() {
 	bus_name = "WhisperMicCapture_" + String::num_int64((int64_t)this);
 	mtx.instantiate();
+	producer_mtx.instantiate();
 	sem.instantiate();
+
+	// in MetricStage order
+	metrics.add_stage("capture");
+	metrics.add_stage("resample");
+	metrics.add_stage("wait");
+	metrics.add_stage("lock");
+	metrics.add_stage("mel");
+	metrics.add_stage("transcribe");
+	metrics.add_stage("step");
+	metrics.add_stage("rtf");
 }
 
 WhisperMicrophoneTranscriber::~WhisperMicrophoneTranscriber() {
+	metrics.remove_monitors();
 	stop();
 	_cleanup_audio_bus();
 }
@@ -34,9 +49,36 @@ void WhisperMicrophoneTranscriber::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_keep_ms", "keep_ms"), &WhisperMicrophoneTranscriber::set_keep_ms);
 	ClassDB::bind_method(D_METHOD("get_keep_ms"), &WhisperMicrophoneTranscriber::get_keep_ms);
 
+	ClassDB::bind_method(D_METHOD("set_mode", "mode"), &WhisperMicrophoneTranscriber::set_mode);
+	ClassDB::bind_method(D_METHOD("get_mode"), &WhisperMicrophoneTranscriber::get_mode);
+
+	ClassDB::bind_method(D_METHOD("set_partial_results", "partial_results"), &WhisperMicrophoneTranscriber::set_partial_results);
+	ClassDB::bind_method(D_METHOD("get_partial_results"), &WhisperMicrophoneTranscriber::get_partial_results);
+
+	ClassDB::bind_method(D_METHOD("set_reuse_mel", "reuse_mel"), &WhisperMicrophoneTranscriber::set_reuse_mel);
+	ClassDB::bind_method(D_METHOD("get_reuse_mel"), &WhisperMicrophoneTranscriber::get_reuse_mel);
+
+	ClassDB::bind_method(D_METHOD("set_batch_results", "batch_results"), &WhisperMicrophoneTranscriber::set_batch_results);
+	ClassDB::bind_method(D_METHOD("get_batch_results"), &WhisperMicrophoneTranscriber::get_batch_results);
+
 	ClassDB::bind_method(D_METHOD("set_bus_name", "bus_name"), &WhisperMicrophoneTranscriber::set_bus_name);
 	ClassDB::bind_method(D_METHOD("get_bus_name"), &WhisperMicrophoneTranscriber::get_bus_name);
 
+	ClassDB::bind_method(D_METHOD("set_use_microphone", "use_microphone"), &WhisperMicrophoneTranscriber::set_use_microphone);
+	ClassDB::bind_method(D_METHOD("get_use_microphone"), &WhisperMicrophoneTranscriber::get_use_microphone);
+
+	ClassDB::bind_method(D_METHOD("set_vad_enabled", "vad_enabled"), &WhisperMicrophoneTranscriber::set_vad_enabled);
+	ClassDB::bind_method(D_METHOD("get_vad_enabled"), &WhisperMicrophoneTranscriber::get_vad_enabled);
+
+	ClassDB::bind_method(D_METHOD("set_vad_threshold", "vad_threshold"), &WhisperMicrophoneTranscriber::set_vad_threshold);
+	ClassDB::bind_method(D_METHOD("get_vad_threshold"), &WhisperMicrophoneTranscriber::get_vad_threshold);
+
+	ClassDB::bind_method(D_METHOD("set_vad_silence_ms", "vad_silence_ms"), &WhisperMicrophoneTranscriber::set_vad_silence_ms);
+	ClassDB::bind_method(D_METHOD("get_vad_silence_ms"), &WhisperMicrophoneTranscriber::get_vad_silence_ms);
+
+	ClassDB::bind_method(D_METHOD("set_vad_pad_ms", "vad_pad_ms"), &WhisperMicrophoneTranscriber::set_vad_pad_ms);
+	ClassDB::bind_method(D_METHOD("get_vad_pad_ms"), &WhisperMicrophoneTranscriber::get_vad_pad_ms);
+
 	ClassDB::bind_method(D_METHOD("start"), &WhisperMicrophoneTranscriber::start);
 	ClassDB::bind_method(D_METHOD("stop"), &WhisperMicrophoneTranscriber::stop);
 	ClassDB::bind_method(D_METHOD("is_running"), &WhisperMicrophoneTranscriber::is_running);
@@ -46,25 +88,52 @@ void WhisperMicrophoneTranscriber::_bind_methods() {
 
 	ClassDB::bind_method(D_METHOD("push_audio_chunk", "samples"), &WhisperMicrophoneTranscriber::push_audio_chunk);
 
+	ClassDB::bind_method(D_METHOD("get_metrics"), &WhisperMicrophoneTranscriber::get_metrics);
+	ClassDB::bind_method(D_METHOD("reset_metrics"), &WhisperMicrophoneTranscriber::reset_metrics);
+	ClassDB::bind_method(D_METHOD("add_performance_monitors", "prefix"), &WhisperMicrophoneTranscriber::add_performance_monitors, DEFVAL("WhisperTranscriber"));
+	ClassDB::bind_method(D_METHOD("remove_performance_monitors"), &WhisperMicrophoneTranscriber::remove_performance_monitors);
+	ClassDB::bind_method(D_METHOD("_get_metric", "stage", "percentile"), &WhisperMicrophoneTranscriber::_get_metric);
+
 	// internal thread function (must be callable for GDExtension Thread)
 	ClassDB::bind_method(D_METHOD("_thread_func"), &WhisperMicrophoneTranscriber::_thread_func);
+	ClassDB::bind_method(D_METHOD("_on_whisper_init_failed", "error"), &WhisperMicrophoneTranscriber::_on_whisper_init_failed);
+	ClassDB::bind_method(D_METHOD("_on_whisper_initialized"), &WhisperMicrophoneTranscriber::_on_whisper_initialized);
 
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "whisper", PROPERTY_HINT_RESOURCE_TYPE, "WhisperFull"), "set_whisper", "get_whisper");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "step_ms", PROPERTY_HINT_RANGE, "500,10000,100"), "set_step_ms", "get_step_ms");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "length_ms", PROPERTY_HINT_RANGE, "1000,30000,100"), "set_length_ms", "get_length_ms");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "keep_ms", PROPERTY_HINT_RANGE, "0,2000,50"), "set_keep_ms", "get_keep_ms");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "mode", PROPERTY_HINT_ENUM, "SlidingWindow,Utterance"), "set_mode", "get_mode");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "partial_results"), "set_partial_results", "get_partial_results");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "reuse_mel"), "set_reuse_mel", "get_reuse_mel");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "batch_results"), "set_batch_results", "get_batch_results");
 	ADD_PROPERTY(PropertyInfo(Variant::STRING, "bus_name", PROPERTY_HINT_NONE, "The name of the audio bus used for transcription"), "set_bus_name", "get_bus_name");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_microphone"), "set_use_microphone", "get_use_microphone");
+
+	ADD_GROUP("Voice Activity", "vad_");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "vad_enabled"), "set_vad_enabled", "get_vad_enabled");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "vad_threshold", PROPERTY_HINT_RANGE, "1.0,20.0,0.1"), "set_vad_threshold", "get_vad_threshold");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "vad_silence_ms", PROPERTY_HINT_RANGE, "100,5000,20"), "set_vad_silence_ms", "get_vad_silence_ms");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "vad_pad_ms", PROPERTY_HINT_RANGE, "0,1000,20"), "set_vad_pad_ms", "get_vad_pad_ms");
 
 	ADD_SIGNAL(MethodInfo("transcription_text", PropertyInfo(Variant::STRING, "text")));
 	ADD_SIGNAL(MethodInfo("transcription_segment", PropertyInfo(Variant::OBJECT, "segment", PROPERTY_HINT_RESOURCE_TYPE, "WhisperSegment")));
 	ADD_SIGNAL(MethodInfo("transcription_started"));
 	ADD_SIGNAL(MethodInfo("transcription_stopped"));
 	ADD_SIGNAL(MethodInfo("transcription_error", PropertyInfo(Variant::STRING, "error")));
+	ADD_SIGNAL(MethodInfo("transcription_partial", PropertyInfo(Variant::STRING, "text")));
+	ADD_SIGNAL(MethodInfo("transcription_batch", PropertyInfo(Variant::DICTIONARY, "results")));
+	ADD_SIGNAL(MethodInfo("speech_started"));
+	ADD_SIGNAL(MethodInfo("speech_ended"));
+
+	BIND_ENUM_CONSTANT(MODE_SLIDING_WINDOW);
+	BIND_ENUM_CONSTANT(MODE_UTTERANCE);
 }
 
 void WhisperMicrophoneTranscriber::_notification(int p_what) {
 	switch (p_what) {
 		case NOTIFICATION_INTERNAL_PROCESS: {
+			_capture_audio();
 			_emit_pending_results();
 		} break;
 		case NOTIFICATION_EXIT_TREE: {
@@ -88,6 +157,10 @@ Ref<WhisperFull> WhisperMicrophoneTranscriber::get_whisper() const {
 }
 
 void WhisperMicrophoneTranscriber::set_step_ms(int p_step_ms) {
+	if (running.is_set()) {
+		ERR_PRINT("[WhisperMicrophoneTranscriber] cannot change step_ms while running");
+		return;
+	}
 	step_ms = CLAMP(p_step_ms, 500, 10000);
 }
 
@@ -96,6 +169,10 @@ int WhisperMicrophoneTranscriber::get_step_ms() const {
 }
 
 void WhisperMicrophoneTranscriber::set_length_ms(int p_length_ms) {
+	if (running.is_set()) {
+		ERR_PRINT("[WhisperMicrophoneTranscriber] cannot change length_ms while running");
+		return;
+	}
 	length_ms = CLAMP(p_length_ms, 1000, 30000);
 }
 
@@ -104,6 +181,10 @@ int WhisperMicrophoneTranscriber::get_length_ms() const {
 }
 
 void WhisperMicrophoneTranscriber::set_keep_ms(int p_keep_ms) {
+	if (running.is_set()) {
+		ERR_PRINT("[WhisperMicrophoneTranscriber] cannot change keep_ms while running");
+		return;
+	}
 	keep_ms = CLAMP(p_keep_ms, 0, 2000);
 }
 
@@ -111,6 +192,46 @@ int WhisperMicrophoneTranscriber::get_keep_ms() const {
 	return keep_ms;
 }
 
+void WhisperMicrophoneTranscriber::set_mode(Mode p_mode) {
+	if (running.is_set()) {
+		ERR_PRINT("[WhisperMicrophoneTranscriber] cannot change mode while running");
+		return;
+	}
+	mode = p_mode;
+}
+
+WhisperMicrophoneTranscriber::Mode WhisperMicrophoneTranscriber::get_mode() const {
+	return mode;
+}
+
+void WhisperMicrophoneTranscriber::set_partial_results(bool p_partial_results) {
+	partial_results = p_partial_results;
+}
+
+bool WhisperMicrophoneTranscriber::get_partial_results() const {
+	return partial_results;
+}
+
+void WhisperMicrophoneTranscriber::set_reuse_mel(bool p_reuse_mel) {
+	reuse_mel = p_reuse_mel;
+}
+
+bool WhisperMicrophoneTranscriber::get_reuse_mel() const {
+	return reuse_mel;
+}
+
+void WhisperMicrophoneTranscriber::set_batch_results(bool p_batch_results) {
+	if (running.is_set()) {
+		ERR_PRINT("[WhisperMicrophoneTranscriber] cannot change batch_results while running");
+		return;
+	}
+	batch_results = p_batch_results;
+}
+
+bool WhisperMicrophoneTranscriber::get_batch_results() const {
+	return batch_results;
+}
+
 void WhisperMicrophoneTranscriber::set_bus_name(const String &p_bus_name) {
 	if (running.is_set()) {
 		ERR_PRINT("[WhisperMicrophoneTranscriber] cannot change bus name while running");
@@ -124,6 +245,66 @@ String WhisperMicrophoneTranscriber::get_bus_name() const {
 	return bus_name;
 }
 
+void WhisperMicrophoneTranscriber::set_use_microphone(bool p_use_microphone) {
+	if (running.is_set()) {
+		ERR_PRINT("[WhisperMicrophoneTranscriber] cannot change use_microphone while running");
+		return;
+	}
+	use_microphone = p_use_microphone;
+}
+
+bool WhisperMicrophoneTranscriber::get_use_microphone() const {
+	return use_microphone;
+}
+
+void WhisperMicrophoneTranscriber::set_vad_enabled(bool p_vad_enabled) {
+	if (running.is_set()) {
+		ERR_PRINT("[WhisperMicrophoneTranscriber] cannot change vad_enabled while running");
+		return;
+	}
+	vad_enabled = p_vad_enabled;
+}
+
+bool WhisperMicrophoneTranscriber::get_vad_enabled() const {
+	return vad_enabled;
+}
+
+void WhisperMicrophoneTranscriber::set_vad_threshold(float p_vad_threshold) {
+	if (running.is_set()) {
+		ERR_PRINT("[WhisperMicrophoneTranscriber] cannot change vad_threshold while running");
+		return;
+	}
+	vad_threshold = CLAMP(p_vad_threshold, 1.0f, 20.0f);
+}
+
+float WhisperMicrophoneTranscriber::get_vad_threshold() const {
+	return vad_threshold;
+}
+
+void WhisperMicrophoneTranscriber::set_vad_silence_ms(int p_vad_silence_ms) {
+	if (running.is_set()) {
+		ERR_PRINT("[WhisperMicrophoneTranscriber] cannot change vad_silence_ms while running");
+		return;
+	}
+	vad_silence_ms = CLAMP(p_vad_silence_ms, 100, 5000);
+}
+
+int WhisperMicrophoneTranscriber::get_vad_silence_ms() const {
+	return vad_silence_ms;
+}
+
+void WhisperMicrophoneTranscriber::set_vad_pad_ms(int p_vad_pad_ms) {
+	if (running.is_set()) {
+		ERR_PRINT("[WhisperMicrophoneTranscriber] cannot change vad_pad_ms while running");
+		return;
+	}
+	vad_pad_ms = CLAMP(p_vad_pad_ms, 0, 1000);
+}
+
+int WhisperMicrophoneTranscriber::get_vad_pad_ms() const {
+	return vad_pad_ms;
+}
+
 /* --- audio bus setup --- */
 
 void WhisperMicrophoneTranscriber::_setup_audio_stream() {
@@ -151,9 +332,14 @@ void WhisperMicrophoneTranscriber::_setup_audio_bus() {
 		int effect_count = audio_server->get_bus_effect_count(bus_index);
 		Ref<AudioEffect> last_effect = audio_server->get_bus_effect(bus_index, effect_count - 1);
 
-		Ref<AudioEffectCapture> capture_effect = Ref<AudioEffectCapture>(last_effect);
-		if (last_effect.is_null() || !capture_effect.is_valid()) {
-			ERR_PRINT("[WhisperMicrophoneTranscriber] last bus effect on custom bus must be an AudioEffectCapture effect");
+		capture_effect = Ref<AudioEffectWhisperCapture>(last_effect);
+		if (capture_effect.is_valid()) {
+			return;
+		}
+
+		Ref<AudioEffectCapture> polled_effect = Ref<AudioEffectCapture>(last_effect);
+		if (last_effect.is_null() || !polled_effect.is_valid()) {
+			ERR_PRINT("[WhisperMicrophoneTranscriber] last bus effect on custom bus must be an AudioEffectWhisperCapture or AudioEffectCapture effect");
 		}
 
 		audio_effect = last_effect;
@@ -169,12 +355,46 @@ void WhisperMicrophoneTranscriber::_setup_audio_bus() {
 	audio_server->set_bus_mute(bus_index, true); // mute to prevent feedback
 
 	// add capture effect
-	audio_effect.instantiate();
-	audio_effect->set_buffer_length(float(length_ms) / 1000.0f + 1.0f);
-	audio_server->add_bus_effect(bus_index, audio_effect);
+	capture_effect.instantiate();
+	audio_server->add_bus_effect(bus_index, capture_effect);
+}
+
+// the buffers the audio thread writes to are sized here, before it sees this node
+void WhisperMicrophoneTranscriber::_attach_capture() {
+	if (capture_effect.is_null()) {
+		return;
+	}
+
+	capture_mono.resize(CAPTURE_BLOCK);
+	resampler.setup(AudioServer::get_singleton()->get_mix_rate());
+	resampler.reserve(CAPTURE_BLOCK);
+	pcmf32_capture.resize(MAX((int)pcmf32_capture.size(), resampler.get_max_output(CAPTURE_BLOCK)));
+
+	capture_effect->set_transcriber(this);
+}
+
+// while the native capture is attached the audio thread is the ring's producer,
+// anything else producing or resetting it holds the AudioServer lock
+bool WhisperMicrophoneTranscriber::_lock_capture() {
+	if (capture_effect.is_null() || !capture_effect->has_transcriber()) {
+		return false;
+	}
+	AudioServer::get_singleton()->lock();
+	return true;
+}
+
+void WhisperMicrophoneTranscriber::_unlock_capture(bool p_locked) {
+	if (p_locked) {
+		AudioServer::get_singleton()->unlock();
+	}
 }
 
 void WhisperMicrophoneTranscriber::_cleanup_audio_bus() {
+	// the audio thread is done with this node once this returns
+	if (capture_effect.is_valid()) {
+		capture_effect->set_transcriber(nullptr);
+	}
+
 	if (mic_player) {
 		mic_player->stop();
 		mic_player->queue_free();
@@ -192,6 +412,7 @@ void WhisperMicrophoneTranscriber::_cleanup_audio_bus() {
 			bus_index = -1;
 		}
 		
+		capture_effect.unref();
 		audio_effect.unref();
 	}
 }
@@ -211,29 +432,55 @@ bool WhisperMicrophoneTranscriber::start() {
 	}
 
 	if (!whisper->is_initialized()) {
-		if (!whisper->init()) {
+		// load in the background, audio is captured and queued until the model is ready
+		if (!whisper->init_async()) {
 			ERR_PRINT("[WhisperMicrophoneTranscriber] failed to initialize whisper");
 			emit_signal("transcription_error", String("failed to initialize whisper"));
 			return false;
 		}
+
+		Callable on_init_failed = Callable(this, "_on_whisper_init_failed");
+		if (!whisper->is_connected("init_failed", on_init_failed)) {
+			whisper->connect("init_failed", on_init_failed);
+		}
+
+		// audio buffered while loading is processed as soon as the model is ready
+		Callable on_initialized = Callable(this, "_on_whisper_initialized");
+		if (!whisper->is_connected("initialized", on_initialized)) {
+			whisper->connect("initialized", on_initialized);
+		}
 	}
 
-	// setup audio capture
-	_setup_audio_stream();
+	// setup audio capture, without a microphone push_audio_chunk is the only input
+	if (use_microphone) {
+		_setup_audio_stream();
+	}
 
-	// clear buffers
+	// allocate the audio buffers once for the whole session
 	{
+		const int whisper_sample_rate = 16000;
+		const int n_samples_len = int(float(length_ms) * whisper_sample_rate / 1000.0f);
+		const int n_samples_keep = int(float(keep_ms) * whisper_sample_rate / 1000.0f);
+
 		mtx->lock();
 
-		pcmf32_buffer.clear();
-		pcmf32_old.clear();
-		pending_texts.clear();
-		pending_segments.clear();
+		// the window holds at most the whole ring plus the kept tail of the previous window
+		pcmf32_ring.resize(n_samples_len + n_samples_keep);
+		pcmf32_window.reserve(pcmf32_ring.get_capacity() + n_samples_len + n_samples_keep);
+		pcmf32_window.clear();
+		window_reset.clear();
+		step_signaled.clear();
+		resampler.reset();
+		_reset_voice_detector();
 		mtx->unlock();
 	}
 
+	_clear_pending_results();
 	accumulated_time = 0.0f;
 
+	// from now on the audio thread writes into the ring
+	_attach_capture();
+
 	// start thread
 	should_stop.clear();
 	running.set();
@@ -253,6 +500,8 @@ void WhisperMicrophoneTranscriber::stop() {
 		return;
 	}
 
+	// also aborts the window being transcribed instead of waiting for whisper_full to return,
+	// other calls on a shared WhisperFull keep running
 	should_stop.set();
 
 	sem->post(); // wake up thread if waiting
@@ -264,6 +513,16 @@ void WhisperMicrophoneTranscriber::stop() {
 	running.clear();
 	set_process_internal(false);
 
+	Callable on_init_failed = Callable(this, "_on_whisper_init_failed");
+	if (whisper.is_valid() && whisper->is_connected("init_failed", on_init_failed)) {
+		whisper->disconnect("init_failed", on_init_failed);
+	}
+
+	Callable on_initialized = Callable(this, "_on_whisper_initialized");
+	if (whisper.is_valid() && whisper->is_connected("initialized", on_initialized)) {
+		whisper->disconnect("initialized", on_initialized);
+	}
+
 	_cleanup_audio_bus();
 
 	emit_signal("transcription_stopped");
@@ -284,15 +543,23 @@ void WhisperMicrophoneTranscriber::reset_bus_name() {
 
 void WhisperMicrophoneTranscriber::clear_buffers() {
 	{
+		producer_mtx->lock();
+		bool capture_locked = _lock_capture();
 		mtx->lock();
 
-		pcmf32_buffer.clear();
-		pcmf32_old.clear();
-		pending_texts.clear();
-		pending_segments.clear();
+		// the worker may still be transcribing the window, it drops it itself
+		pcmf32_ring.clear();
+		window_reset.set();
+		step_signaled.clear();
+		resampler.reset();
+		_reset_voice_detector();
 		mtx->unlock();
+		_unlock_capture(capture_locked);
+		producer_mtx->unlock();
 	}
 
+	_clear_pending_results();
+
 	if (audio_effect.is_valid())
 	{
 		audio_effect->clear_buffer();
@@ -306,160 +573,537 @@ void WhisperMicrophoneTranscriber::push_audio_chunk(const PackedFloat32Array &p_
 		return;
 	}
 
-	mtx->lock();
-	pcmf32_buffer.append_array(p_samples);
-	mtx->unlock();
+	// may be called from any thread, so pushes never run concurrently with each other or with polling
+	producer_mtx->lock();
+
+	// the AudioServer lock stalls the mixer, it is only held for one capture block at a time
+	const float *samples = p_samples.ptr();
+	for (int offset = 0; offset < p_samples.size(); offset += CAPTURE_BLOCK) {
+		bool capture_locked = _lock_capture();
+		_append_audio(samples + offset, MIN(CAPTURE_BLOCK, (int)p_samples.size() - offset));
+		_unlock_capture(capture_locked);
+	}
+
+	producer_mtx->unlock();
 }
 
-/* --- thread function --- */
+/* --- audio capture --- */
 
-void WhisperMicrophoneTranscriber::_thread_func() {
-	const int whisper_sample_rate = 16000;
-	const int n_samples_step = int(float(step_ms) * whisper_sample_rate / 1000.0f);
+// audio thread, once per mix block of the capture bus. the block is downmixed and resampled
+// into preallocated buffers and goes straight to the ring
+void WhisperMicrophoneTranscriber::_capture_frames(const AudioFrame *p_frames, int p_count) {
+	uint64_t t_capture = Time::get_singleton()->get_ticks_usec();
+	uint64_t resample_usec = 0;
 
-	while (!should_stop.is_set()) {
-		// capture audio from microphone
-		if (audio_effect.is_valid()) {
-			int frames_available = audio_effect->get_frames_available();
-			if (frames_available > 0) {
-				PackedVector2Array stereo_data = audio_effect->get_buffer(frames_available);
-				audio_effect->clear_buffer();
+	for (int offset = 0; offset < p_count; offset += CAPTURE_BLOCK) {
+		const int n_frames = MIN(CAPTURE_BLOCK, p_count - offset);
+		const AudioFrame *frames = p_frames + offset;
+		float *mono = capture_mono.ptr();
+		for (int i = 0; i < n_frames; i++) {
+			mono[i] = (frames[i].left + frames[i].right) * 0.5f;
+		}
 
-				AudioServer *audio_server = AudioServer::get_singleton();
-				int sample_rate = audio_server->get_mix_rate();
+		uint64_t t_resample = Time::get_singleton()->get_ticks_usec();
+		int n_samples = resampler.process_mono(mono, n_frames, pcmf32_capture.ptr());
+		resample_usec += Time::get_singleton()->get_ticks_usec() - t_resample;
 
-				PackedFloat32Array mono_data = WhisperFull::convert_stereo_to_mono_16khz(sample_rate, stereo_data);
+		if (n_samples > 0) {
+			_append_audio(pcmf32_capture.ptr(), n_samples);
+		}
+	}
 
-				if (!mono_data.is_empty()) {
-					mtx->lock();
-					pcmf32_buffer.append_array(mono_data);
-					mtx->unlock();
-				}
+	metrics.record(METRIC_RESAMPLE, resample_usec);
+	metrics.record(METRIC_CAPTURE, Time::get_singleton()->get_ticks_usec() - t_capture);
+}
+
+// called every frame on the main thread, drains a polled AudioEffectCapture into the buffer
+void WhisperMicrophoneTranscriber::_capture_audio() {
+	if (audio_effect.is_null()) {
+		return;
+	}
+
+	int frames_available = audio_effect->get_frames_available();
+	if (frames_available <= 0) {
+		return;
+	}
+
+	uint64_t t_capture = Time::get_singleton()->get_ticks_usec();
+
+	PackedVector2Array stereo_data = audio_effect->get_buffer(frames_available);
+
+	// the resampler and detector state are shared with push_audio_chunk and clear_buffers
+	producer_mtx->lock();
+
+	AudioServer *audio_server = AudioServer::get_singleton();
+	int sample_rate = audio_server->get_mix_rate();
+	if (resampler.get_from_rate() != sample_rate) {
+		resampler.setup(sample_rate);
+	}
+
+	// the output buffer only grows when a frame captures more audio than any before
+	int max_output = resampler.get_max_output(stereo_data.size());
+	if ((int)pcmf32_capture.size() < max_output) {
+		pcmf32_capture.resize(max_output);
+	}
+
+	uint64_t t_resample = Time::get_singleton()->get_ticks_usec();
+	int n_samples = resampler.process_stereo(stereo_data.ptr(), stereo_data.size(), pcmf32_capture.ptr());
+	metrics.record(METRIC_RESAMPLE, Time::get_singleton()->get_ticks_usec() - t_resample);
+
+	if (n_samples > 0) {
+		_append_audio(pcmf32_capture.ptr(), n_samples);
+	}
+	producer_mtx->unlock();
+
+	// from the capture effect to the ring, what the main thread spends on audio each frame
+	metrics.record(METRIC_CAPTURE, Time::get_singleton()->get_ticks_usec() - t_capture);
+}
+
+// gates incoming 16kHz audio on voice activity before it is queued for the worker
+void WhisperMicrophoneTranscriber::_append_audio(const float *p_samples, int p_count) {
+	// utterance mode needs the detector to find the end of each utterance
+	if (!vad_enabled && mode != MODE_UTTERANCE) {
+		_write_audio(p_samples, p_count);
+		return;
+	}
+
+	int offset = 0;
+	while (offset < p_count) {
+		bool speaking = voice_detector.is_speaking();
+
+		WhisperVoiceDetector::Event event;
+		int n = voice_detector.process(p_samples + offset, p_count - offset, event);
+
+		if (speaking) {
+			_write_audio(p_samples + offset, n);
+		} else {
+			_push_preroll(p_samples + offset, n);
+		}
+		offset += n;
+
+		if (event == WhisperVoiceDetector::EVENT_SPEECH_START) {
+			// the onset frame and the padding before it are still in the preroll
+			_flush_preroll();
+			speech_active.set();
+			speech_started_pending.set();
+		} else if (event == WhisperVoiceDetector::EVENT_SPEECH_END) {
+			// the worker transcribes the rest of the utterance even if it's shorter than a step
+			utterance_ended.set();
+			if (!step_signaled.is_set()) {
+				_signal_step();
 			}
+			speech_active.clear();
+			speech_ended_pending.set();
 		}
+	}
+}
+
+void WhisperMicrophoneTranscriber::_push_preroll(const float *p_samples, int p_count) {
+	int capacity = vad_preroll.size();
+	if (capacity == 0) {
+		return;
+	}
+
+	// only the last capacity samples can survive
+	if (p_count > capacity) {
+		p_samples += p_count - capacity;
+		p_count = capacity;
+	}
+
+	int first = MIN(p_count, capacity - vad_preroll_pos);
+	memcpy(vad_preroll.ptr() + vad_preroll_pos, p_samples, first * sizeof(float));
+	memcpy(vad_preroll.ptr(), p_samples + first, (p_count - first) * sizeof(float));
+
+	vad_preroll_pos = (vad_preroll_pos + p_count) % capacity;
+	vad_preroll_fill = MIN(vad_preroll_fill + p_count, capacity);
+}
+
+void WhisperMicrophoneTranscriber::_flush_preroll() {
+	int capacity = vad_preroll.size();
+	int start = (vad_preroll_pos - vad_preroll_fill + capacity) % MAX(capacity, 1);
+	int first = MIN(vad_preroll_fill, capacity - start);
+
+	_write_audio(vad_preroll.ptr() + start, first);
+	_write_audio(vad_preroll.ptr(), vad_preroll_fill - first);
+
+	vad_preroll_fill = 0;
+}
+
+void WhisperMicrophoneTranscriber::_reset_voice_detector() {
+	const int whisper_sample_rate = 16000;
+
+	voice_detector.reset();
+	voice_detector.set_energy_ratio(vad_threshold);
+	voice_detector.set_hangover_ms(vad_silence_ms);
+
+	// a frame is only known to be speech once it is complete, so the preroll holds at least the onset frame
+	vad_preroll.resize(MAX(vad_pad_ms * whisper_sample_rate / 1000, WhisperVoiceDetector::FRAME_SIZE));
+	vad_preroll_pos = 0;
+	vad_preroll_fill = 0;
+	utterance_ended.clear();
+	speech_active.clear();
+}
+
+// wakes the worker once per step, the worker never polls.
+// audio that doesn't fit in the ring (the worker fell behind) is dropped
+void WhisperMicrophoneTranscriber::_write_audio(const float *p_samples, int p_count) {
+	if (p_count <= 0) {
+		return;
+	}
+
+	const int whisper_sample_rate = 16000;
+	const int n_samples_step = int(float(step_ms) * whisper_sample_rate / 1000.0f);
+	const int n_samples_len = int(float(length_ms) * whisper_sample_rate / 1000.0f);
+
+	pcmf32_ring.write(p_samples, p_count);
+
+	// while the model is loading the worker is only woken to drop audio older than one window
+	int n_wake = whisper->is_initialized() ? n_samples_step : n_samples_len;
+	if (!step_signaled.is_set() && (int)pcmf32_ring.get_available() >= n_wake) {
+		_signal_step();
+	}
+}
+
+void WhisperMicrophoneTranscriber::_signal_step() {
+	step_signal_usec.store(Time::get_singleton()->get_ticks_usec());
+	step_signaled.set();
+	sem->post();
+}
+
+/* --- thread function --- */
+
+void WhisperMicrophoneTranscriber::_thread_func() {
+	while (true) {
+		// posted by _append_audio once a step is complete, by the model finishing to load and by stop()
+		sem->wait();
 
-		// check if we have enough samples to process
-		bool should_process = false;
-		{
-			mtx->lock();
-			should_process = pcmf32_buffer.size() >= n_samples_step;
-			mtx->unlock();
+		if (should_stop.is_set()) {
+			break;
 		}
 
-		if (should_process) {
+		if (whisper->is_initialized()) {
 			_process_audio();
 		} else {
-			// sleep a bit to avoid busy waiting
-			OS::get_singleton()->delay_usec(10000); // 10ms
+			_trim_audio();
 		}
 	}
 }
 
+// model is still loading, only keep the most recent window of audio
+void WhisperMicrophoneTranscriber::_trim_audio() {
+	const int whisper_sample_rate = 16000;
+	const int n_samples_len = int(float(length_ms) * whisper_sample_rate / 1000.0f);
+
+	mtx->lock();
+	step_signaled.clear();
+
+	uint32_t available = pcmf32_ring.get_available();
+	if (available > (uint32_t)n_samples_len) {
+		pcmf32_ring.advance_read(available - n_samples_len);
+	}
+	mtx->unlock();
+}
+
 void WhisperMicrophoneTranscriber::_process_audio() {
 	const int whisper_sample_rate = 16000;
 	const int n_samples_step = int(float(step_ms) * whisper_sample_rate / 1000.0f);
 	const int n_samples_len = int(float(length_ms) * whisper_sample_rate / 1000.0f);
 	const int n_samples_keep = int(float(keep_ms) * whisper_sample_rate / 1000.0f);
 
-	PackedFloat32Array pcmf32_new;
-	PackedFloat32Array pcmf32_old_copy;
+	// whisper's own vad needs the samples, the spectrogram can't be handed over then
+	const bool use_mel = reuse_mel && !whisper->get_vad_enable();
+	if (!use_mel) {
+		mel_cache.reset();
+		mel_pending = 0;
+	} else if (mel_cache.get_n_mels() != whisper->get_model_n_mels()) {
+		mel_cache.setup(whisper->get_model_n_mels());
+	}
+
+	// the step started when the worker was signaled, audio that woke it while it was busy waited here too
+	uint64_t t_wake = Time::get_singleton()->get_ticks_usec();
+	uint64_t t_signal = step_signal_usec.exchange(0);
+	if (t_signal == 0 || t_signal > t_wake) {
+		t_signal = t_wake;
+	}
+	metrics.record(METRIC_WAIT, t_wake - t_signal);
 
-	// get audio from buffer
+	bool utterance_end = false;
+	bool partial = false;
+	int n_step_samples = 0;
 	{
 		mtx->lock();
+		metrics.record(METRIC_LOCK, Time::get_singleton()->get_ticks_usec() - t_wake);
 
-		if (pcmf32_buffer.size() < n_samples_step) {
-			mtx->unlock();
-			return;
+		// cleared before reading, audio written from now on wakes the worker again
+		step_signaled.clear();
+
+		// clear_buffers ran since the last step
+		if (window_reset.is_set()) {
+			window_reset.clear();
+			pcmf32_window.clear();
 		}
 
-		// take audio from buffer
-		pcmf32_new = pcmf32_buffer;
-		pcmf32_buffer.clear();
+		// an utterance ended, whatever is left is transcribed now
+		utterance_end = utterance_ended.is_set();
+		utterance_ended.clear();
 
-		pcmf32_old_copy = pcmf32_old;
+		const float *new_first = nullptr;
+		const float *new_second = nullptr;
+		uint32_t n_first = 0;
+		uint32_t n_second = 0;
+		int n_samples_new = pcmf32_ring.get_read_regions(new_first, n_first, new_second, n_second);
+
+		// a new window starts a new frame grid, it is aligned by construction
+		if (use_mel && pcmf32_window.is_empty()) {
+			mel_cache.reset();
+			mel_pending = 0;
+		}
+
+		if (mode == MODE_UTTERANCE) {
+			// the utterance grows until it ends (or reaches length_ms), nothing is decoded twice
+			// except for the optional partial results
+			int n_samples_old = pcmf32_window.size();
+			pcmf32_window.resize(n_samples_old + n_samples_new);
+			float *window_ptr = pcmf32_window.ptr();
+			memcpy(window_ptr + n_samples_old, new_first, n_first * sizeof(float));
+			memcpy(window_ptr + n_samples_old + n_first, new_second, n_second * sizeof(float));
+
+			pcmf32_ring.advance_read(n_samples_new);
+			mel_pending += use_mel ? n_samples_new : 0;
+			n_step_samples = n_samples_new;
+
+			utterance_end = utterance_end || (int)pcmf32_window.size() >= n_samples_len;
+			partial = !utterance_end;
+
+			bool skip = pcmf32_window.is_empty() || (partial && (!partial_results || n_samples_new < n_samples_step));
+			if (skip) {
+				mtx->unlock();
+				return;
+			}
+		} else {
+			if (utterance_end && n_samples_new == 0) {
+				pcmf32_window.clear();
+				mtx->unlock();
+				return;
+			}
+
+			if (n_samples_new < n_samples_step && !utterance_end) {
+				mtx->unlock();
+				return;
+			}
+
+			// calculate how many old samples to keep (to mitigate word boundary issues)
+			int n_samples_old = pcmf32_window.size();
+			int n_samples_take = MIN(n_samples_old, MAX(0, n_samples_keep + n_samples_len - n_samples_new));
+
+			// keep a little less (under 10ms) so the window starts on a frame step
+			int64_t window_start = mel_cache.get_end() + mel_pending - n_samples_take;
+			if (use_mel && window_start >= 0) {
+				n_samples_take = MAX(0, n_samples_take - int((WHISPER_HOP_LENGTH - window_start % WHISPER_HOP_LENGTH) % WHISPER_HOP_LENGTH));
+			}
+
+			// slide the kept tail to the front, then append the new samples straight out of the ring
+			float *window_ptr = pcmf32_window.ptr();
+			memmove(window_ptr, window_ptr + n_samples_old - n_samples_take, n_samples_take * sizeof(float));
+
+			pcmf32_window.resize(n_samples_take + n_samples_new);
+			window_ptr = pcmf32_window.ptr();
+			memcpy(window_ptr + n_samples_take, new_first, n_first * sizeof(float));
+			memcpy(window_ptr + n_samples_take + n_first, new_second, n_second * sizeof(float));
+
+			pcmf32_ring.advance_read(n_samples_new);
+			mel_pending += use_mel ? n_samples_new : 0;
+			n_step_samples = n_samples_new;
+		}
 		mtx->unlock();
 	}
 
-	// calculate how many old samples to keep (to mitigate word boundary issues)
-	int n_samples_take = MIN(pcmf32_old_copy.size(), MAX(0, n_samples_keep + n_samples_len - pcmf32_new.size()));
+	// with stream signals, sliding window segments are forwarded as whisper decodes them.
+	// utterance mode only reports the segments of the final decode, batches carry them packed
+	bool stream_segments = mode != MODE_UTTERANCE && !batch_results && whisper->get_stream_signals();
 
-	// combine old and new samples
-	PackedFloat32Array pcmf32;
-	pcmf32.resize(n_samples_take + pcmf32_new.size());
+	// transcribe, the window stays untouched until the next step
+	uint64_t t_transcribe = Time::get_singleton()->get_ticks_usec();
+	int result = _transcribe_window(use_mel, stream_segments);
+	uint64_t transcribe_usec = Time::get_singleton()->get_ticks_usec() - t_transcribe;
+	metrics.record(METRIC_TRANSCRIBE, transcribe_usec);
 
-	float *pcmf32_ptr = pcmf32.ptrw();
+	// in thousandths, below 1000 the worker keeps up with the microphone
+	if (n_step_samples > 0) {
+		metrics.record(METRIC_RTF, transcribe_usec * 1000 / ((uint64_t)n_step_samples * 1000000 / WHISPER_SAMPLE_RATE));
+	}
 
-	// copy old samples
-	if (n_samples_take > 0) {
-		const float *old_ptr = pcmf32_old_copy.ptr();
-		int old_size = pcmf32_old_copy.size();
-		for (int i = 0; i < n_samples_take; i++) {
-			pcmf32_ptr[i] = old_ptr[old_size - n_samples_take + i];
+	if (result == 0) {
+		StepResult step;
+		step.partial = partial;
+		step.text = whisper->get_full_text();
+		if (step.text.strip_edges().is_empty()) {
+			step.text = String();
+		}
+
+		bool has_segments = false;
+		if (batch_results) {
+			step.segments_packed = whisper->get_segments_packed();
+			has_segments = whisper->get_segment_count() > 0;
+		} else if (mode == MODE_UTTERANCE ? !partial : !stream_segments) {
+			LocalVector<Ref<WhisperSegment>> segments;
+			whisper->get_all_segments_native(segments);
+			for (const Ref<WhisperSegment> &seg : segments) {
+				if (seg.is_valid() && !seg->get_text().strip_edges().is_empty()) {
+					step.segments.push_back(seg);
+				}
+			}
+			has_segments = !step.segments.is_empty();
 		}
-	}
 
-	// copy new samples
-	const float *new_ptr = pcmf32_new.ptr();
-	for (int i = 0; i < pcmf32_new.size(); i++) {
-		pcmf32_ptr[n_samples_take + i] = new_ptr[i];
+		// queue results to be emitted on main thread
+		if (!step.text.is_empty() || has_segments) {
+			pending_results.push(step);
+		}
+
+		// from the audio that woke the worker to its results waiting for the main thread
+		metrics.record(METRIC_STEP, Time::get_singleton()->get_ticks_usec() - t_signal);
 	}
 
-	// save samples for next iteration
-	{
+	// the next utterance starts with a fresh window instead of the tail of this one
+	if (utterance_end) {
 		mtx->lock();
-		pcmf32_old = pcmf32;
+		pcmf32_window.clear();
 		mtx->unlock();
 	}
+}
 
-	// transcribe
-	int result = whisper->transcribe(pcmf32);
+// the new audio is at the end of the window, only its frames are computed before decoding
+int WhisperMicrophoneTranscriber::_transcribe_window(bool p_use_mel, bool p_stream_segments) {
+	const int n_samples = pcmf32_window.size();
 
-	if (result == 0) {
-		// get results
-		String full_text = whisper->get_full_text();
-		LocalVector<Ref<WhisperSegment>> segments;
-		whisper->get_all_segments_native(segments);
+	WhisperCallHooks hooks;
+	hooks.cancel = &should_stop;
+	if (p_stream_segments) {
+		hooks.segment_callback = _on_whisper_segment;
+		hooks.userdata = this;
+	}
 
-        //print_line(full_text);
+	if (p_use_mel) {
+		uint64_t t_mel = Time::get_singleton()->get_ticks_usec();
+		mel_cache.append(pcmf32_window.ptr() + n_samples - mel_pending, mel_pending);
+		mel_pending = 0;
 
-		// queue results to be emitted on main thread
-		mtx->lock();
+		int64_t window_start = mel_cache.get_end() - n_samples;
+		mel_cache.discard_before(window_start);
 
-		if (!full_text.strip_edges().is_empty()) {
-			pending_texts.push_back(full_text);
+		// falls back to the samples while the window still holds audio from before the cache was reset
+		int n_len = window_start >= 0 ? mel_cache.build(window_start, mel_window) : 0;
+		metrics.record(METRIC_MEL, Time::get_singleton()->get_ticks_usec() - t_mel);
+		if (n_len > 0) {
+			return whisper->transcribe_mel_native(mel_window.ptr(), n_len, n_samples, &hooks);
 		}
+	}
 
-		for (int i = 0; i < segments.size(); i++) {
-			Ref<WhisperSegment> seg = segments[i];
-			if (seg.is_valid() && !seg->get_text().strip_edges().is_empty()) {
-				pending_segments.push_back(seg);
-			}
-		}
-		mtx->unlock();
+	return whisper->transcribe_native(pcmf32_window.ptr(), n_samples, &hooks);
+}
+
+void WhisperMicrophoneTranscriber::_on_whisper_init_failed(const String &p_error) {
+	ERR_PRINT("[WhisperMicrophoneTranscriber] failed to initialize whisper: " + p_error);
+	emit_signal("transcription_error", p_error);
+	stop();
+}
+
+// called on the worker while whisper decodes the window, the main thread emits the segment
+// on its next frame, ahead of the step's text
+void WhisperMicrophoneTranscriber::_on_whisper_segment(void *p_userdata, const Ref<WhisperSegment> &p_segment) {
+	WhisperMicrophoneTranscriber *self = (WhisperMicrophoneTranscriber *)p_userdata;
+
+	if (p_segment.is_valid() && !p_segment->get_text().strip_edges().is_empty()) {
+		StepResult step;
+		step.segments.push_back(p_segment);
+		self->pending_results.push(step);
 	}
 }
 
+void WhisperMicrophoneTranscriber::_on_whisper_initialized() {
+	_signal_step();
+}
+
+/* --- metrics --- */
+
+Dictionary WhisperMicrophoneTranscriber::get_metrics() const {
+	return metrics.get_dictionary();
+}
+
+void WhisperMicrophoneTranscriber::reset_metrics() {
+	metrics.reset();
+}
+
+void WhisperMicrophoneTranscriber::add_performance_monitors(const String &p_prefix) {
+	metrics.add_monitors(this, p_prefix);
+}
+
+void WhisperMicrophoneTranscriber::remove_performance_monitors() {
+	metrics.remove_monitors();
+}
+
+double WhisperMicrophoneTranscriber::_get_metric(int p_stage, double p_percentile) const {
+	return metrics.get_percentile(p_stage, p_percentile);
+}
+
 /* --- emit results on main thread --- */
 
+// runs every frame, nothing but a few atomic loads while no step finished
 void WhisperMicrophoneTranscriber::_emit_pending_results() {
-	LocalVector<String> texts_to_emit;
-	LocalVector<Ref<WhisperSegment>> segments_to_emit;
+	// the detector may report events from the audio thread, which must not touch signals.
+	// if speech ended and started again since the last frame, it is still going on
+	bool started = speech_started_pending.is_set();
+	bool ended = speech_ended_pending.is_set();
+	if (started) {
+		speech_started_pending.clear();
+	}
+	if (ended) {
+		speech_ended_pending.clear();
+	}
+	if (started && ended && speech_active.is_set()) {
+		emit_signal("speech_ended");
+		emit_signal("speech_started");
+	} else {
+		if (started) {
+			emit_signal("speech_started");
+		}
+		if (ended) {
+			emit_signal("speech_ended");
+		}
+	}
 
-	{
-		mtx->lock();
-		texts_to_emit = pending_texts;
-		segments_to_emit = pending_segments;
-		pending_texts.clear();
-		pending_segments.clear();
-		mtx->unlock();
+	if (pending_results.is_empty()) {
+		return;
 	}
 
-	for (const String &text : texts_to_emit) {
-		emit_signal("transcription_text", text);
+	StepResult step;
+	while (pending_results.pop(step)) {
+		if (batch_results) {
+			// { text, partial, segments: get_segments_packed() }
+			Dictionary results;
+			results["text"] = step.text;
+			results["partial"] = step.partial;
+			results["segments"] = step.segments_packed;
+			emit_signal("transcription_batch", results);
+			continue;
+		}
+
+		if (!step.text.is_empty()) {
+			emit_signal(step.partial ? "transcription_partial" : "transcription_text", step.text);
+		}
+
+		for (const Ref<WhisperSegment> &seg : step.segments) {
+			emit_signal("transcription_segment", seg);
+		}
 	}
+}
 
-	for (const Ref<WhisperSegment> &seg : segments_to_emit) {
-		emit_signal("transcription_segment", seg);
+// main thread only, like _emit_pending_results
+void WhisperMicrophoneTranscriber::_clear_pending_results() {
+	StepResult step;
+	while (pending_results.pop(step)) {
 	}
+	speech_started_pending.clear();
+	speech_ended_pending.clear();
 }
@@ -14,54 +14,151 @@
 #include <godot_cpp/variant/packed_vector2_array.hpp>
 using namespace godot;
 
+#include "audio_effect_whisper_capture.h"
+#include "mpsc_queue.h"
+#include "spsc_ring_buffer.h"
 #include "whisper_full.h"
+#include "whisper_mel_spectrogram.h"
+#include "whisper_metrics.h"
+#include "whisper_resampler.h"
+#include "whisper_voice_detector.h"
 
 // this class provides real-time microphone transcription using whisper
 // it captures audio from the microphone, processes it in a background thread,
-// and emits signals with transcribed text segments
+// and emits signals with transcribed text segments.
+// with the WhisperFull's stream_signals on, sliding window segments are emitted as they are decoded,
+// so "transcription_segment" comes before the "transcription_text" of the same step
 class WhisperMicrophoneTranscriber : public Node {
 	GDCLASS(WhisperMicrophoneTranscriber, Node);
 
+	friend class AudioEffectWhisperCaptureInstance;
+
+	static const int CAPTURE_BLOCK = 1024; // frames downmixed and resampled at once on the audio thread
+
+public:
+	enum Mode {
+		MODE_SLIDING_WINDOW, // re-decode overlapping windows every step_ms
+		MODE_UTTERANCE, // decode each utterance once it ends, with optional partial results every step_ms
+	};
+
+private:
+
 	// whisper instance
 	Ref<WhisperFull> whisper;
 
-	// audio capture
+	// audio capture, the native effect feeds the ring from the audio thread.
+	// an AudioEffectCapture at the end of a custom bus is still supported and polled every frame instead
+	Ref<AudioEffectWhisperCapture> capture_effect;
 	Ref<AudioEffectCapture> audio_effect;
 	AudioStreamPlayer *mic_player = nullptr;
 	int bus_index = -1;
 	String bus_name;
 	bool use_custom_bus = false;
+	bool use_microphone = true; // false feeds the transcriber through push_audio_chunk only
 
 	// streaming parameters (similar to whisper.cpp stream example)
 	int step_ms = 3000;      // process audio every N milliseconds
 	int length_ms = 10000;   // maximum audio length to process
 	int keep_ms = 200;       // audio to keep from previous step (to avoid word boundary issues)
+	Mode mode = MODE_SLIDING_WINDOW;
+	bool partial_results = true; // utterance mode only
+	bool reuse_mel = true;       // compute the spectrogram of each sample once instead of every step
+	bool batch_results = false;  // one "transcription_batch" per step instead of a signal per result, not while running
+
+	// voice activity gating, silence never reaches the ring (and therefore whisper)
+	bool vad_enabled = false;
+	float vad_threshold = 3.0f; // frame energy over the noise floor
+	int vad_silence_ms = 500;   // pause that ends an utterance
+	int vad_pad_ms = 200;       // audio kept from before the detected speech onset
 
 	// threading
 	Ref<Thread> worker_thread;
 	Ref<Mutex> mtx;
-	Ref<Semaphore> sem;
+	Ref<Semaphore> sem; // posted once a step's worth of audio is buffered
 	SafeFlag running;
 	SafeFlag should_stop;
 
-	// audio buffers (protected by mutex)
-	PackedFloat32Array pcmf32_buffer;     // buffer for incoming audio
-	PackedFloat32Array pcmf32_old;        // audio kept from previous transcription
-
-	// results queue (protected by mutex)
-	LocalVector<String> pending_texts;
-	LocalVector<Ref<WhisperSegment>> pending_segments;
+	// incoming audio, read by the worker without locking. sized for length_ms + keep_ms,
+	// reads and clears also hold the mutex so clear_buffers can't race the worker.
+	// there is one producer at a time: the audio thread while the native capture is attached (anything else
+	// writing holds the AudioServer lock as well), and whoever holds producer_mtx otherwise
+	SPSCRingBuffer<float> pcmf32_ring;
+	Ref<Mutex> producer_mtx;              // polling, push_audio_chunk from any thread and clear_buffers
+	WhisperResampler resampler;           // mix rate -> 16kHz mono, keeps its state between frames
+	LocalVector<float> pcmf32_capture;    // resampler output, reused every frame
+	LocalVector<float> capture_mono;      // downmixed mix block, native capture only
+	WhisperVoiceDetector voice_detector;  // runs on the producer side
+	LocalVector<float> vad_preroll;       // circular, the most recent vad_pad_ms of gated audio
+	int vad_preroll_pos = 0;
+	int vad_preroll_fill = 0;
+	SafeFlag utterance_ended;             // the worker transcribes what's left and starts a new window
+	SafeFlag speech_active;               // speech_started/speech_ended are emitted by the main thread from these
+	SafeFlag speech_started_pending;
+	SafeFlag speech_ended_pending;
+	SafeFlag step_signaled;               // the worker was woken for the audio in the ring
+	std::atomic<uint64_t> step_signal_usec{ 0 }; // when it was woken, for the wait and step latencies
+
+	// audio passed to whisper, preallocated and advanced in place: each step keeps the tail
+	// of the previous window at the front and appends the new audio behind it
+	LocalVector<float> pcmf32_window;
+	SafeFlag window_reset; // set by clear_buffers, the worker empties the window before its next step
+
+	// log-mel frames of the audio appended to the window, only used by the worker.
+	// the window starts on a frame step whenever possible so the frames of the kept audio carry over
+	WhisperMelSpectrogram mel_cache;
+	LocalVector<float> mel_window;
+	int mel_pending = 0; // samples at the end of the window not appended to mel_cache yet
+
+	// results of one step, pushed by the worker and drained by the main thread without locking
+	struct StepResult {
+		bool partial = false;
+		String text;
+		LocalVector<Ref<WhisperSegment>> segments;
+		Dictionary segments_packed; // batch_results only, instead of segments
+	};
+	MPSCQueue<StepResult> pending_results;
 
 	// timing
 	float accumulated_time = 0.0f;
 
+	// per-stage histograms, capture and resample on the audio thread (the main thread when polling), the rest on the worker
+	enum MetricStage {
+		METRIC_CAPTURE,
+		METRIC_RESAMPLE,
+		METRIC_WAIT,
+		METRIC_LOCK,
+		METRIC_MEL,
+		METRIC_TRANSCRIBE,
+		METRIC_STEP,
+		METRIC_RTF,
+	};
+	WhisperMetrics metrics;
+
 	// internal methods
 	void _thread_func();
 	void _process_audio();
+	void _capture_audio();
+	void _capture_frames(const AudioFrame *p_frames, int p_count);
+	void _attach_capture();
+	bool _lock_capture();
+	void _unlock_capture(bool p_locked);
+	void _append_audio(const float *p_samples, int p_count);
+	void _write_audio(const float *p_samples, int p_count);
+	void _signal_step();
+	double _get_metric(int p_stage, double p_percentile) const;
+	void _push_preroll(const float *p_samples, int p_count);
+	void _flush_preroll();
+	void _reset_voice_detector();
+	void _trim_audio();
+	int _transcribe_window(bool p_use_mel, bool p_stream_segments);
 	void _setup_audio_bus();
 	void _setup_audio_stream();
 	void _cleanup_audio_bus();
 	void _emit_pending_results();
+	void _clear_pending_results();
+	void _on_whisper_init_failed(const String &p_error);
+	void _on_whisper_initialized();
+	static void _on_whisper_segment(void *p_userdata, const Ref<WhisperSegment> &p_segment);
 
 protected:
 	static void _bind_methods();
@@ -72,7 +169,7 @@ public:
 	void set_whisper(const Ref<WhisperFull> &p_whisper);
 	Ref<WhisperFull> get_whisper() const;
 
-	// streaming parameters
+	// streaming parameters, fixed while running
 	void set_step_ms(int p_step_ms);
 	int get_step_ms() const;
 
@@ -82,8 +179,36 @@ public:
 	void set_keep_ms(int p_keep_ms);
 	int get_keep_ms() const;
 
+	void set_mode(Mode p_mode);
+	Mode get_mode() const;
+
+	void set_partial_results(bool p_partial_results);
+	bool get_partial_results() const;
+
+	void set_reuse_mel(bool p_reuse_mel);
+	bool get_reuse_mel() const;
+
+	void set_batch_results(bool p_batch_results);
+	bool get_batch_results() const;
+
 	void set_bus_name(const String &p_bus_name);
 	String get_bus_name() const;
+
+	void set_use_microphone(bool p_use_microphone);
+	bool get_use_microphone() const;
+
+	// voice activity gating
+	void set_vad_enabled(bool p_vad_enabled);
+	bool get_vad_enabled() const;
+
+	void set_vad_threshold(float p_vad_threshold);
+	float get_vad_threshold() const;
+
+	void set_vad_silence_ms(int p_vad_silence_ms);
+	int get_vad_silence_ms() const;
+
+	void set_vad_pad_ms(int p_vad_pad_ms);
+	int get_vad_pad_ms() const;
 	
 	// control methods
 	bool start();
@@ -96,6 +221,15 @@ public:
 	// manual audio input (alternative to microphone)
 	void push_audio_chunk(const PackedFloat32Array &p_samples);
 
+	// p50/p95/p99 of every stage from capture to queued results (ms) and realtime factor
+	Dictionary get_metrics() const;
+	void reset_metrics();
+
+	void add_performance_monitors(const String &p_prefix = "WhisperTranscriber");
+	void remove_performance_monitors();
+
 	WhisperMicrophoneTranscriber();
 	~WhisperMicrophoneTranscriber();
 };
+
+VARIANT_ENUM_CAST(WhisperMicrophoneTranscriber::Mode);
@@ -28,6 +28,7 @@ Variant ResourceFormatLoaderWhisperModel::_load(const String &p_path, const Stri
 PackedStringArray ResourceFormatLoaderWhisperModel::_get_recognized_extensions() const {
     PackedStringArray exts;
     exts.push_back("bin");
+    exts.push_back("whispermodel");
     return exts;
 }
 
@@ -35,7 +36,8 @@ bool ResourceFormatLoaderWhisperModel::_handles_type(const StringName &type) con
 	return ClassDB::is_parent_class(type, "WhisperModel");
 }
 String ResourceFormatLoaderWhisperModel::_get_resource_type(const String &p_path) const {
-	if (p_path.get_extension().to_lower() == "bin") {
+	String extension = p_path.get_extension().to_lower();
+	if (extension == "bin" || extension == "whispermodel") {
 		return "WhisperModel";
 	}
 	return String();
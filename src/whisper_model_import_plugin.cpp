@@ -0,0 +1,119 @@
+#include "whisper_model_import_plugin.h"
+
+#include <godot_cpp/core/class_db.hpp>
+using namespace godot;
+
+#include "whisper_model_quantizer.h"
+
+/* --- WhisperModelImportPlugin implementation --- */
+
+void WhisperModelImportPlugin::_bind_methods() {
+}
+
+String WhisperModelImportPlugin::_get_importer_name() const {
+	return "whisper.model";
+}
+
+String WhisperModelImportPlugin::_get_visible_name() const {
+	return "Whisper Model";
+}
+
+PackedStringArray WhisperModelImportPlugin::_get_recognized_extensions() const {
+	PackedStringArray extensions;
+	extensions.push_back("ggml");
+	return extensions;
+}
+
+String WhisperModelImportPlugin::_get_save_extension() const {
+	return "whispermodel";
+}
+
+String WhisperModelImportPlugin::_get_resource_type() const {
+	return "WhisperModel";
+}
+
+double WhisperModelImportPlugin::_get_priority() const {
+	return 1.0;
+}
+
+int32_t WhisperModelImportPlugin::_get_import_order() const {
+	return 0;
+}
+
+// one preset per quantization, in Quantization order
+int32_t WhisperModelImportPlugin::_get_preset_count() const {
+	return 5;
+}
+
+String WhisperModelImportPlugin::_get_preset_name(int32_t p_preset_index) const {
+	switch (p_preset_index) {
+		case QUANTIZATION_Q5_1:
+			return "Q5_1";
+		case QUANTIZATION_Q5_0:
+			return "Q5_0";
+		case QUANTIZATION_Q4_1:
+			return "Q4_1";
+		case QUANTIZATION_Q4_0:
+			return "Q4_0";
+		default:
+			return "Q8_0";
+	}
+}
+
+TypedArray<Dictionary> WhisperModelImportPlugin::_get_import_options(const String &p_path, int32_t p_preset_index) const {
+	TypedArray<Dictionary> options;
+
+	// q4_0 and q8_0 are repacked for the running cpu's kernels (AVX2, NEON, ...) when the model is loaded
+	Dictionary quantization;
+	quantization["name"] = "quantization";
+	quantization["default_value"] = CLAMP(p_preset_index, (int32_t)QUANTIZATION_Q8_0, (int32_t)QUANTIZATION_Q4_0);
+	quantization["property_hint"] = PROPERTY_HINT_ENUM;
+	quantization["hint_string"] = "Q8_0,Q5_1,Q5_0,Q4_1,Q4_0";
+	options.push_back(quantization);
+
+	return options;
+}
+
+bool WhisperModelImportPlugin::_get_option_visibility(const String &p_path, const StringName &p_option_name, const Dictionary &p_options) const {
+	return true;
+}
+
+Error WhisperModelImportPlugin::_import(const String &p_source_file, const String &p_save_path, const Dictionary &p_options, const TypedArray<String> &p_platform_variants, const TypedArray<String> &p_gen_files) const {
+	ggml_type type = GGML_TYPE_Q8_0;
+	switch (int(p_options.get("quantization", QUANTIZATION_Q8_0))) {
+		case QUANTIZATION_Q5_1:
+			type = GGML_TYPE_Q5_1;
+			break;
+		case QUANTIZATION_Q5_0:
+			type = GGML_TYPE_Q5_0;
+			break;
+		case QUANTIZATION_Q4_1:
+			type = GGML_TYPE_Q4_1;
+			break;
+		case QUANTIZATION_Q4_0:
+			type = GGML_TYPE_Q4_0;
+			break;
+		default:
+			break;
+	}
+
+	return WhisperModelQuantizer::quantize(p_source_file, p_save_path + "." + _get_save_extension(), type);
+}
+
+/* --- WhisperEditorPlugin implementation --- */
+
+void WhisperEditorPlugin::_bind_methods() {
+}
+
+void WhisperEditorPlugin::_notification(int p_what) {
+	switch (p_what) {
+		case NOTIFICATION_ENTER_TREE: {
+			model_import_plugin.instantiate();
+			add_import_plugin(model_import_plugin);
+		} break;
+		case NOTIFICATION_EXIT_TREE: {
+			remove_import_plugin(model_import_plugin);
+			model_import_plugin.unref();
+		} break;
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <godot_cpp/classes/editor_import_plugin.hpp>
+#include <godot_cpp/classes/editor_plugin.hpp>
+#include <godot_cpp/variant/typed_array.hpp>
+using namespace godot;
+
+// this class imports whisper ggml models renamed to .ggml into .godot/imported, quantized.
+// .bin models are left to ResourceFormatLoaderWhisperModel, which loads them as they are, so other binaries
+// are never claimed and unquantized models are not duplicated. the imported file keeps the ggml format,
+// smaller weights load faster and make the encoder and decoder faster on the cpu
+class WhisperModelImportPlugin : public EditorImportPlugin {
+	GDCLASS(WhisperModelImportPlugin, EditorImportPlugin);
+
+public:
+	enum Quantization {
+		QUANTIZATION_Q8_0,
+		QUANTIZATION_Q5_1,
+		QUANTIZATION_Q5_0,
+		QUANTIZATION_Q4_1,
+		QUANTIZATION_Q4_0,
+	};
+
+protected:
+	static void _bind_methods();
+
+public:
+	virtual String _get_importer_name() const override;
+	virtual String _get_visible_name() const override;
+	virtual PackedStringArray _get_recognized_extensions() const override;
+	virtual String _get_save_extension() const override;
+	virtual String _get_resource_type() const override;
+	virtual double _get_priority() const override;
+	virtual int32_t _get_import_order() const override;
+	virtual int32_t _get_preset_count() const override;
+	virtual String _get_preset_name(int32_t p_preset_index) const override;
+	virtual TypedArray<Dictionary> _get_import_options(const String &p_path, int32_t p_preset_index) const override;
+	virtual bool _get_option_visibility(const String &p_path, const StringName &p_option_name, const Dictionary &p_options) const override;
+	virtual Error _import(const String &p_source_file, const String &p_save_path, const Dictionary &p_options, const TypedArray<String> &p_platform_variants, const TypedArray<String> &p_gen_files) const override;
+};
+
+// this class registers the editor side of the extension
+class WhisperEditorPlugin : public EditorPlugin {
+	GDCLASS(WhisperEditorPlugin, EditorPlugin);
+
+	Ref<WhisperModelImportPlugin> model_import_plugin;
+
+protected:
+	static void _bind_methods();
+	void _notification(int p_what);
+};
@@ -0,0 +1,261 @@
+#include "whisper_model_loader.h"
+
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/classes/project_settings.hpp>
+#include <godot_cpp/core/memory.hpp>
+using namespace godot;
+
+#include <cstring>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#define WHISPER_LOADER_MMAP
+#elif !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define WHISPER_LOADER_MMAP
+#endif
+
+static void _report_progress(WhisperLoadProgress *p_progress, size_t p_bytes_read) {
+	if (p_progress == nullptr) {
+		return;
+	}
+
+	p_progress->bytes_loaded += p_bytes_read;
+	if (p_progress->callback) {
+		p_progress->callback(p_progress->userdata, p_progress->bytes_loaded, p_progress->bytes_total);
+	}
+}
+
+// a canceled load reads zeros and reports eof, whisper.cpp then fails on the missing tensors
+static bool _is_canceled(const WhisperLoadProgress *p_progress) {
+	return p_progress != nullptr && p_progress->cancel != nullptr && p_progress->cancel->is_set();
+}
+
+/* --- memory-mapped files --- */
+
+#ifdef WHISPER_LOADER_MMAP
+
+// consumed pages are handed back to the OS in chunks of this size, so the mapping
+// never keeps more than one chunk of already copied weights resident
+static const size_t MAPPED_RELEASE_CHUNK = 16 * 1024 * 1024;
+
+struct MappedModelFile {
+	const uint8_t *data = nullptr;
+	size_t size = 0;
+	size_t offset = 0;
+	size_t released = 0;
+	WhisperLoadProgress *progress = nullptr;
+
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#else
+	int fd = -1;
+#endif
+};
+
+static void _mapped_close(void *p_ctx) {
+	MappedModelFile *mf = (MappedModelFile *)p_ctx;
+
+#ifdef _WIN32
+	if (mf->data) {
+		UnmapViewOfFile(mf->data);
+	}
+	if (mf->mapping) {
+		CloseHandle(mf->mapping);
+	}
+	if (mf->file != INVALID_HANDLE_VALUE) {
+		CloseHandle(mf->file);
+	}
+#else
+	if (mf->data) {
+		munmap((void *)mf->data, mf->size);
+	}
+	if (mf->fd >= 0) {
+		close(mf->fd);
+	}
+#endif
+
+	memdelete(mf);
+}
+
+static void _mapped_release_consumed(MappedModelFile *p_mf) {
+#ifndef _WIN32
+	// the mapping is page aligned and the chunk size is a multiple of the page size
+	size_t end = (p_mf->offset / MAPPED_RELEASE_CHUNK) * MAPPED_RELEASE_CHUNK;
+	if (end > p_mf->released) {
+		madvise((void *)(p_mf->data + p_mf->released), end - p_mf->released, MADV_DONTNEED);
+		p_mf->released = end;
+	}
+#endif
+}
+
+static size_t _mapped_read(void *p_ctx, void *p_output, size_t p_read_size) {
+	MappedModelFile *mf = (MappedModelFile *)p_ctx;
+
+	if (_is_canceled(mf->progress)) {
+		memset(p_output, 0, p_read_size);
+		return p_read_size;
+	}
+
+	size_t n = MIN(p_read_size, mf->size - mf->offset);
+	memcpy(p_output, mf->data + mf->offset, n);
+	mf->offset += n;
+
+	_mapped_release_consumed(mf);
+	_report_progress(mf->progress, n);
+	return n;
+}
+
+static bool _mapped_eof(void *p_ctx) {
+	MappedModelFile *mf = (MappedModelFile *)p_ctx;
+	return mf->offset >= mf->size || _is_canceled(mf->progress);
+}
+
+static MappedModelFile *_mapped_open(const String &p_global_path) {
+	MappedModelFile *mf = memnew(MappedModelFile);
+
+#ifdef _WIN32
+	Char16String path_w = p_global_path.utf16();
+	mf->file = CreateFileW((LPCWSTR)path_w.get_data(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (mf->file == INVALID_HANDLE_VALUE) {
+		_mapped_close(mf);
+		return nullptr;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mf->file, &size) || size.QuadPart <= 0) {
+		_mapped_close(mf);
+		return nullptr;
+	}
+	mf->size = (size_t)size.QuadPart;
+
+	mf->mapping = CreateFileMappingW(mf->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mf->mapping == nullptr) {
+		_mapped_close(mf);
+		return nullptr;
+	}
+
+	mf->data = (const uint8_t *)MapViewOfFile(mf->mapping, FILE_MAP_READ, 0, 0, 0);
+	if (mf->data == nullptr) {
+		_mapped_close(mf);
+		return nullptr;
+	}
+#else
+	CharString path_cs = p_global_path.utf8();
+	mf->fd = open(path_cs.get_data(), O_RDONLY);
+	if (mf->fd < 0) {
+		_mapped_close(mf);
+		return nullptr;
+	}
+
+	struct stat st;
+	if (fstat(mf->fd, &st) != 0 || st.st_size <= 0) {
+		_mapped_close(mf);
+		return nullptr;
+	}
+	mf->size = (size_t)st.st_size;
+
+	void *data = mmap(nullptr, mf->size, PROT_READ, MAP_PRIVATE, mf->fd, 0);
+	if (data == MAP_FAILED) {
+		_mapped_close(mf);
+		return nullptr;
+	}
+	mf->data = (const uint8_t *)data;
+
+	// weights are read front to back exactly once
+	madvise(data, mf->size, MADV_SEQUENTIAL);
+#endif
+
+	return mf;
+}
+
+#endif // WHISPER_LOADER_MMAP
+
+/* --- FileAccess streaming (PCK / virtual file systems) --- */
+
+struct StreamedModelFile {
+	Ref<FileAccess> file;
+	uint64_t size = 0;
+	WhisperLoadProgress *progress = nullptr;
+};
+
+static void _streamed_close(void *p_ctx) {
+	StreamedModelFile *sf = (StreamedModelFile *)p_ctx;
+	sf->file.unref();
+	memdelete(sf);
+}
+
+static size_t _streamed_read(void *p_ctx, void *p_output, size_t p_read_size) {
+	StreamedModelFile *sf = (StreamedModelFile *)p_ctx;
+
+	if (_is_canceled(sf->progress)) {
+		memset(p_output, 0, p_read_size);
+		return p_read_size;
+	}
+
+	uint64_t n = sf->file->get_buffer((uint8_t *)p_output, p_read_size);
+	_report_progress(sf->progress, n);
+	return n;
+}
+
+static bool _streamed_eof(void *p_ctx) {
+	StreamedModelFile *sf = (StreamedModelFile *)p_ctx;
+	return sf->file->get_position() >= sf->size || _is_canceled(sf->progress);
+}
+
+/* --- WhisperModelLoader implementation --- */
+
+whisper_context *WhisperModelLoader::init_context(const String &p_path, const whisper_context_params &p_params, WhisperLoadProgress *p_progress) {
+	whisper_model_loader loader;
+
+#ifdef WHISPER_LOADER_MMAP
+	String global_path = ProjectSettings::get_singleton()->globalize_path(p_path);
+	MappedModelFile *mf = _mapped_open(global_path);
+	if (mf) {
+		mf->progress = p_progress;
+		if (p_progress) {
+			p_progress->bytes_total = mf->size;
+		}
+
+		loader.context = mf;
+		loader.read = _mapped_read;
+		loader.eof = _mapped_eof;
+		loader.close = _mapped_close;
+
+		// the loader is closed by whisper.cpp, on success and on failure
+		return whisper_init_with_params_no_state(&loader, p_params);
+	}
+#endif
+
+	// not a regular file on disk (e.g. packed in a PCK), stream it instead
+	Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::READ);
+	if (file.is_null()) {
+		ERR_PRINT("[WhisperModelLoader] failed to open model file: " + p_path);
+		return nullptr;
+	}
+
+	StreamedModelFile *sf = memnew(StreamedModelFile);
+	sf->file = file;
+	sf->size = file->get_length();
+	sf->progress = p_progress;
+	if (p_progress) {
+		p_progress->bytes_total = sf->size;
+	}
+
+	loader.context = sf;
+	loader.read = _streamed_read;
+	loader.eof = _streamed_eof;
+	loader.close = _streamed_close;
+
+	return whisper_init_with_params_no_state(&loader, p_params);
+}
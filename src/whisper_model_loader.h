@@ -0,0 +1,29 @@
+#pragma once
+
+#include <godot_cpp/templates/safe_refcount.hpp>
+#include <godot_cpp/variant/string.hpp>
+using namespace godot;
+
+#include <whisper.h>
+
+// model load progress, reported from the loading thread
+struct WhisperLoadProgress {
+	uint64_t bytes_loaded = 0;
+	uint64_t bytes_total = 0;
+
+	void (*callback)(void *p_userdata, uint64_t p_bytes_loaded, uint64_t p_bytes_total) = nullptr;
+	void *userdata = nullptr;
+
+	// once set, the load gives up at its next read
+	const SafeFlag *cancel = nullptr;
+};
+
+// this class feeds model files to whisper.cpp through a whisper_model_loader,
+// so tensors are streamed straight into the ggml buffers instead of going through
+// an intermediate copy of the whole file.
+// files on disk are memory-mapped, files that only exist inside a PCK are streamed through FileAccess.
+// contexts are created without a state, callers create their own with whisper_init_state.
+class WhisperModelLoader {
+public:
+	static whisper_context *init_context(const String &p_path, const whisper_context_params &p_params, WhisperLoadProgress *p_progress = nullptr);
+};
@@ -0,0 +1,159 @@
+#include "whisper_model_quantizer.h"
+
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+using namespace godot;
+
+#include <cstring>
+
+static const uint32_t WHISPER_MAGIC = 0x67676d6c; // "ggml"
+static const int N_HPARAMS = 11; // n_vocab ... n_mels, then ftype
+static const int HPARAM_FTYPE = 10;
+
+// tensors whisper.cpp creates as f32 whatever the model's type is
+static const char *KEEP_TENSORS[] = {
+	"encoder.conv1.bias",
+	"encoder.conv2.bias",
+	"encoder.positional_embedding",
+	"decoder.positional_embedding",
+};
+
+static ggml_ftype _get_ftype(ggml_type p_type) {
+	switch (p_type) {
+		case GGML_TYPE_Q4_0:
+			return GGML_FTYPE_MOSTLY_Q4_0;
+		case GGML_TYPE_Q4_1:
+			return GGML_FTYPE_MOSTLY_Q4_1;
+		case GGML_TYPE_Q5_0:
+			return GGML_FTYPE_MOSTLY_Q5_0;
+		case GGML_TYPE_Q5_1:
+			return GGML_FTYPE_MOSTLY_Q5_1;
+		case GGML_TYPE_Q8_0:
+			return GGML_FTYPE_MOSTLY_Q8_0;
+		default:
+			return GGML_FTYPE_UNKNOWN;
+	}
+}
+
+static bool _copy_bytes(const Ref<FileAccess> &p_src, const Ref<FileAccess> &p_dst, uint64_t p_size, LocalVector<uint8_t> &r_buffer) {
+	const uint64_t chunk = 1024 * 1024;
+	r_buffer.resize(MIN(p_size, chunk));
+	while (p_size > 0) {
+		uint64_t n = MIN(p_size, chunk);
+		if (p_src->get_buffer(r_buffer.ptr(), n) != n) {
+			return false;
+		}
+		p_dst->store_buffer(r_buffer.ptr(), n);
+		p_size -= n;
+	}
+	return true;
+}
+
+Error WhisperModelQuantizer::quantize(const String &p_source, const String &p_dest, ggml_type p_type) {
+	const ggml_ftype ftype = _get_ftype(p_type);
+	ERR_FAIL_COND_V_MSG(ftype == GGML_FTYPE_UNKNOWN, ERR_INVALID_PARAMETER, "[WhisperModelQuantizer] unsupported quantization type");
+
+	Ref<FileAccess> src = FileAccess::open(p_source, FileAccess::READ);
+	ERR_FAIL_COND_V_MSG(src.is_null(), ERR_FILE_CANT_OPEN, "[WhisperModelQuantizer] failed to open model: " + p_source);
+	ERR_FAIL_COND_V_MSG(src->get_32() != WHISPER_MAGIC, ERR_FILE_UNRECOGNIZED, "[WhisperModelQuantizer] not a whisper ggml model: " + p_source);
+
+	Ref<FileAccess> dst = FileAccess::open(p_dest, FileAccess::WRITE);
+	ERR_FAIL_COND_V_MSG(dst.is_null(), ERR_FILE_CANT_WRITE, "[WhisperModelQuantizer] failed to create: " + p_dest);
+
+	LocalVector<uint8_t> buffer;
+
+	dst->store_32(WHISPER_MAGIC);
+
+	// hyperparameters, the ftype also carries the quantization version
+	int32_t hparams[N_HPARAMS];
+	for (int i = 0; i < N_HPARAMS; i++) {
+		hparams[i] = int32_t(src->get_32());
+	}
+	const int32_t ftype_src = hparams[HPARAM_FTYPE] % GGML_QNT_VERSION_FACTOR;
+	ERR_FAIL_COND_V_MSG(ftype_src != GGML_FTYPE_ALL_F32 && ftype_src != GGML_FTYPE_MOSTLY_F16, ERR_INVALID_DATA, "[WhisperModelQuantizer] model is already quantized: " + p_source);
+
+	hparams[HPARAM_FTYPE] = GGML_QNT_VERSION * GGML_QNT_VERSION_FACTOR + ftype;
+	for (int i = 0; i < N_HPARAMS; i++) {
+		dst->store_32(uint32_t(hparams[i]));
+	}
+
+	// mel filters
+	const int32_t n_mel = int32_t(src->get_32());
+	const int32_t n_fft = int32_t(src->get_32());
+	dst->store_32(uint32_t(n_mel));
+	dst->store_32(uint32_t(n_fft));
+	ERR_FAIL_COND_V_MSG(!_copy_bytes(src, dst, uint64_t(n_mel) * n_fft * sizeof(float), buffer), ERR_FILE_CORRUPT, "[WhisperModelQuantizer] truncated mel filters: " + p_source);
+
+	// vocabulary
+	const int32_t n_vocab = int32_t(src->get_32());
+	dst->store_32(uint32_t(n_vocab));
+	for (int i = 0; i < n_vocab; i++) {
+		const uint32_t length = src->get_32();
+		dst->store_32(length);
+		ERR_FAIL_COND_V_MSG(!_copy_bytes(src, dst, length, buffer), ERR_FILE_CORRUPT, "[WhisperModelQuantizer] truncated vocabulary: " + p_source);
+	}
+
+	// tensors
+	LocalVector<float> data_f32;
+	LocalVector<uint8_t> data_q;
+	CharString name;
+	while (true) {
+		const int32_t n_dims = int32_t(src->get_32());
+		const int32_t name_length = int32_t(src->get_32());
+		const int32_t ttype = int32_t(src->get_32());
+		if (src->eof_reached()) {
+			break;
+		}
+		ERR_FAIL_COND_V_MSG(n_dims < 1 || n_dims > 4 || name_length <= 0, ERR_FILE_CORRUPT, "[WhisperModelQuantizer] invalid tensor header: " + p_source);
+
+		int32_t ne[4] = { 1, 1, 1, 1 };
+		int64_t n_elements = 1;
+		for (int i = 0; i < n_dims; i++) {
+			ne[i] = int32_t(src->get_32());
+			n_elements *= ne[i];
+		}
+
+		name.resize(name_length + 1);
+		src->get_buffer((uint8_t *)name.ptrw(), name_length);
+		name.ptrw()[name_length] = '\0';
+
+		ERR_FAIL_COND_V_MSG(ttype != GGML_TYPE_F32 && ttype != GGML_TYPE_F16, ERR_INVALID_DATA, "[WhisperModelQuantizer] unexpected tensor type in: " + p_source);
+		const uint64_t n_bytes = uint64_t(n_elements) * (ttype == GGML_TYPE_F32 ? sizeof(float) : sizeof(ggml_fp16_t));
+
+		bool keep = n_dims != 2 || ne[0] % ggml_blck_size(p_type) != 0;
+		for (const char *keep_name : KEEP_TENSORS) {
+			keep = keep || strcmp(name.get_data(), keep_name) == 0;
+		}
+
+		dst->store_32(uint32_t(n_dims));
+		dst->store_32(uint32_t(name_length));
+		dst->store_32(uint32_t(keep ? ttype : int32_t(p_type)));
+		for (int i = 0; i < n_dims; i++) {
+			dst->store_32(uint32_t(ne[i]));
+		}
+		dst->store_buffer((const uint8_t *)name.get_data(), name_length);
+
+		if (keep) {
+			ERR_FAIL_COND_V_MSG(!_copy_bytes(src, dst, n_bytes, buffer), ERR_FILE_CORRUPT, "[WhisperModelQuantizer] truncated tensor " + String(name.get_data()) + " in: " + p_source);
+			continue;
+		}
+
+		data_f32.resize(n_elements);
+		if (ttype == GGML_TYPE_F32) {
+			ERR_FAIL_COND_V_MSG(src->get_buffer((uint8_t *)data_f32.ptr(), n_bytes) != n_bytes, ERR_FILE_CORRUPT, "[WhisperModelQuantizer] truncated tensor " + String(name.get_data()) + " in: " + p_source);
+		} else {
+			buffer.resize(n_bytes);
+			ERR_FAIL_COND_V_MSG(src->get_buffer(buffer.ptr(), n_bytes) != n_bytes, ERR_FILE_CORRUPT, "[WhisperModelQuantizer] truncated tensor " + String(name.get_data()) + " in: " + p_source);
+			ggml_fp16_to_fp32_row((const ggml_fp16_t *)buffer.ptr(), data_f32.ptr(), n_elements);
+		}
+
+		const int64_t n_rows = n_elements / ne[0];
+		data_q.resize(ggml_row_size(p_type, ne[0]) * n_rows);
+		size_t n_written = ggml_quantize_chunk(p_type, data_f32.ptr(), data_q.ptr(), 0, n_rows, ne[0], nullptr);
+		dst->store_buffer(data_q.ptr(), n_written);
+	}
+
+	dst->flush();
+	ERR_FAIL_COND_V_MSG(dst->get_error() != OK, ERR_FILE_CANT_WRITE, "[WhisperModelQuantizer] failed to write: " + p_dest);
+	return OK;
+}
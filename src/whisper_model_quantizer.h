@@ -0,0 +1,15 @@
+#pragma once
+
+#include <godot_cpp/core/error_macros.hpp>
+#include <godot_cpp/variant/string.hpp>
+using namespace godot;
+
+#include <ggml.h>
+
+// this class rewrites a whisper ggml model (.bin) with its weight matrices quantized, like whisper.cpp's
+// quantize example: 2D weights become p_type, biases, norms, convolutions and positional embeddings keep
+// their type. tensors are streamed one at a time through FileAccess, so only the largest one is in memory
+class WhisperModelQuantizer {
+public:
+	static Error quantize(const String &p_source, const String &p_dest, ggml_type p_type);
+};
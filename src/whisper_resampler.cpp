@@ -0,0 +1,236 @@
+#include "whisper_resampler.h"
+
+#include <godot_cpp/core/error_macros.hpp>
+#include <godot_cpp/core/math.hpp>
+using namespace godot;
+
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define WHISPER_RESAMPLER_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WHISPER_RESAMPLER_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define WHISPER_RESAMPLER_NEON
+#endif
+
+// the interleaved kernels read Vector2 as pairs of floats
+#if !defined(REAL_T_IS_DOUBLE)
+#define WHISPER_RESAMPLER_FLOAT_FRAMES
+#endif
+
+// zeroth order modified bessel function of the first kind, for the kaiser window
+static double _bessel_i0(double p_x) {
+	double sum = 1.0;
+	double term = 1.0;
+	const double half_x_sq = p_x * p_x * 0.25;
+	for (int k = 1; k < 64 && term > sum * 1e-12; k++) {
+		term *= half_x_sq / (double(k) * k);
+		sum += term;
+	}
+	return sum;
+}
+
+static int _gcd(int p_a, int p_b) {
+	while (p_b != 0) {
+		int t = p_a % p_b;
+		p_a = p_b;
+		p_b = t;
+	}
+	return p_a;
+}
+
+/* --- SIMD kernels --- */
+
+static float _dot(const float *p_a, const float *p_b, int p_count) {
+#if defined(WHISPER_RESAMPLER_AVX2)
+	__m256 acc = _mm256_setzero_ps();
+	for (int i = 0; i < p_count; i += 8) {
+		acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(p_a + i), _mm256_loadu_ps(p_b + i)));
+	}
+	__m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+	sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+	sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+	return _mm_cvtss_f32(sum);
+#elif defined(WHISPER_RESAMPLER_SSE2)
+	__m128 acc = _mm_setzero_ps();
+	for (int i = 0; i < p_count; i += 4) {
+		acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(p_a + i), _mm_loadu_ps(p_b + i)));
+	}
+	acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+	acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+	return _mm_cvtss_f32(acc);
+#elif defined(WHISPER_RESAMPLER_NEON)
+	float32x4_t acc = vdupq_n_f32(0.0f);
+	for (int i = 0; i < p_count; i += 4) {
+		acc = vmlaq_f32(acc, vld1q_f32(p_a + i), vld1q_f32(p_b + i));
+	}
+	float32x2_t sum = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+	return vget_lane_f32(vpadd_f32(sum, sum), 0);
+#else
+	float acc = 0.0f;
+	for (int i = 0; i < p_count; i++) {
+		acc += p_a[i] * p_b[i];
+	}
+	return acc;
+#endif
+}
+
+// averages left and right of each frame
+static void _downmix(const Vector2 *p_frames, int p_count, float *r_output) {
+	int i = 0;
+
+#if defined(WHISPER_RESAMPLER_FLOAT_FRAMES)
+	const float *src = (const float *)p_frames;
+
+#if defined(WHISPER_RESAMPLER_AVX2)
+	const __m256 half = _mm256_set1_ps(0.5f);
+	for (; i + 8 <= p_count; i += 8) {
+		// hadd pairs up l+r per 128-bit lane, the permute restores frame order
+		__m256 sum = _mm256_hadd_ps(_mm256_loadu_ps(src + i * 2), _mm256_loadu_ps(src + i * 2 + 8));
+		sum = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sum), _MM_SHUFFLE(3, 1, 2, 0)));
+		_mm256_storeu_ps(r_output + i, _mm256_mul_ps(sum, half));
+	}
+#elif defined(WHISPER_RESAMPLER_SSE2)
+	const __m128 half = _mm_set1_ps(0.5f);
+	for (; i + 4 <= p_count; i += 4) {
+		__m128 a = _mm_loadu_ps(src + i * 2);
+		__m128 b = _mm_loadu_ps(src + i * 2 + 4);
+		__m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+		_mm_storeu_ps(r_output + i, _mm_mul_ps(_mm_add_ps(left, right), half));
+	}
+#elif defined(WHISPER_RESAMPLER_NEON)
+	for (; i + 4 <= p_count; i += 4) {
+		float32x4x2_t lr = vld2q_f32(src + i * 2);
+		vst1q_f32(r_output + i, vmulq_n_f32(vaddq_f32(lr.val[0], lr.val[1]), 0.5f));
+	}
+#endif
+#endif // WHISPER_RESAMPLER_FLOAT_FRAMES
+
+	for (; i < p_count; i++) {
+		r_output[i] = (p_frames[i].x + p_frames[i].y) * 0.5f;
+	}
+}
+
+/* --- WhisperResampler implementation --- */
+
+void WhisperResampler::setup(int p_from_rate, int p_to_rate) {
+	ERR_FAIL_COND_MSG(p_from_rate <= 0 || p_to_rate <= 0, "[WhisperResampler] sample rates must be positive");
+
+	from_rate = p_from_rate;
+	to_rate = p_to_rate;
+
+	// 48k -> 16k is 1/3 (a plain decimating filter), 44.1k -> 16k is 160/441
+	int divisor = _gcd(from_rate, to_rate);
+	up = to_rate / divisor;
+	down = from_rate / divisor;
+
+	// low-pass below the lower of both nyquist frequencies, relative to the upsampled rate,
+	// with a bit of room for the transition band
+	const double cutoff = 0.45 / MAX(up, down);
+	const int length = up * TAPS_PER_PHASE;
+	const double center = (length - 1) * 0.5;
+
+	// beta for 60dB of stopband attenuation, 0.1102 * (A - 8.7)
+	const double beta = 0.1102 * (60.0 - 8.7);
+	const double window_norm = 1.0 / _bessel_i0(beta);
+
+	coeffs.resize(length);
+	for (int phase = 0; phase < up; phase++) {
+		for (int tap = 0; tap < TAPS_PER_PHASE; tap++) {
+			int k = phase + tap * up;
+
+			double x = k - center;
+			double sinc = x == 0.0 ? 1.0 : Math::sin(Math_PI * 2.0 * cutoff * x) / (Math_PI * 2.0 * cutoff * x);
+			double r = x / center;
+			double window = _bessel_i0(beta * Math::sqrt(MAX(0.0, 1.0 - r * r))) * window_norm; // kaiser
+
+			// gain of up compensates for the zero stuffing, taps are reversed to run over the history in order
+			coeffs[phase * TAPS_PER_PHASE + (TAPS_PER_PHASE - 1 - tap)] = float(2.0 * cutoff * sinc * window * up);
+		}
+	}
+
+	reset();
+}
+
+void WhisperResampler::reset() {
+	history.resize(TAPS_PER_PHASE - 1);
+	memset(history.ptr(), 0, history.size() * sizeof(float));
+
+	next_index = TAPS_PER_PHASE - 1;
+	next_phase = 0;
+}
+
+void WhisperResampler::reserve(int p_max_frames) {
+	history.reserve(TAPS_PER_PHASE - 1 + p_max_frames);
+}
+
+int WhisperResampler::get_max_output(int p_input_frames) const {
+	if (down == 0) {
+		return 0;
+	}
+	return int((int64_t)(p_input_frames + 1) * up / down) + 1;
+}
+
+// runs the filter over the buffered history, then keeps its tail for the next call
+int WhisperResampler::_filter(float *r_output) {
+	const int size = history.size();
+	const float *src = history.ptr();
+	int n_output = 0;
+
+	if (up == 1) {
+		// integer decimation, every output uses the same filter
+		const float *filter = coeffs.ptr();
+		for (; next_index < size; next_index += down) {
+			r_output[n_output++] = _dot(filter, src + next_index - (TAPS_PER_PHASE - 1), TAPS_PER_PHASE);
+		}
+	} else {
+		while (next_index < size) {
+			const float *filter = coeffs.ptr() + next_phase * TAPS_PER_PHASE;
+			r_output[n_output++] = _dot(filter, src + next_index - (TAPS_PER_PHASE - 1), TAPS_PER_PHASE);
+
+			next_phase += down;
+			next_index += next_phase / up;
+			next_phase %= up;
+		}
+	}
+
+	// positions are relative to the start of history, shift them with the kept samples
+	int drop = size - (TAPS_PER_PHASE - 1);
+	memmove(history.ptr(), history.ptr() + drop, (TAPS_PER_PHASE - 1) * sizeof(float));
+	history.resize(TAPS_PER_PHASE - 1);
+	next_index -= drop;
+
+	return n_output;
+}
+
+int WhisperResampler::process_stereo(const Vector2 *p_frames, int p_count, float *r_output) {
+	ERR_FAIL_COND_V_MSG(from_rate == 0, 0, "[WhisperResampler] setup() was not called");
+	if (p_count <= 0) {
+		return 0;
+	}
+
+	// history keeps its capacity, so this only allocates when a chunk is larger than any before
+	int offset = history.size();
+	history.resize(offset + p_count);
+	_downmix(p_frames, p_count, history.ptr() + offset);
+
+	return _filter(r_output);
+}
+
+int WhisperResampler::process_mono(const float *p_samples, int p_count, float *r_output) {
+	ERR_FAIL_COND_V_MSG(from_rate == 0, 0, "[WhisperResampler] setup() was not called");
+	if (p_count <= 0) {
+		return 0;
+	}
+
+	int offset = history.size();
+	history.resize(offset + p_count);
+	memcpy(history.ptr() + offset, p_samples, p_count * sizeof(float));
+
+	return _filter(r_output);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/variant/vector2.hpp>
+using namespace godot;
+
+#include <whisper.h>
+
+// this class converts a continuous audio stream to whisper's 16kHz mono input.
+// it is a band-limited polyphase resampler (kaiser-windowed sinc low-pass, L/M rational ratio),
+// the filter history and fractional phase carry over between calls so chunk boundaries are seamless.
+// downmixing and the filter dot products use AVX2, SSE2 or NEON when the target supports them.
+class WhisperResampler {
+	// multiple of 8, for the SIMD kernels. with the kaiser window below the stopband is about 60dB down from
+	// about 8.2kHz for 48k -> 16k (7.2kHz cutoff, flat to 6kHz), so hardly anything aliases into whisper's band
+	static const int TAPS_PER_PHASE = 96;
+
+	int from_rate = 0;
+	int to_rate = 0;
+	int up = 1; // L, interpolation factor
+	int down = 1; // M, decimation factor
+
+	LocalVector<float> coeffs; // up * TAPS_PER_PHASE, one reversed filter per phase
+	LocalVector<float> history; // TAPS_PER_PHASE - 1 samples of the previous call, then the current input
+	int next_index = 0; // position of the next output in history
+	int next_phase = 0;
+
+	int _filter(float *r_output);
+
+public:
+	// sets up the filter for a new rate pair and resets the stream
+	void setup(int p_from_rate, int p_to_rate = WHISPER_SAMPLE_RATE);
+	void reset();
+
+	int get_from_rate() const { return from_rate; }
+	int get_to_rate() const { return to_rate; }
+
+	// preallocates for calls of up to p_max_frames, so the audio thread never allocates
+	void reserve(int p_max_frames);
+
+	// upper bound of the samples a call with this many input frames can produce
+	int get_max_output(int p_input_frames) const;
+
+	// both write to r_output, which must hold get_max_output(p_count) samples, and return the count written
+	int process_stereo(const Vector2 *p_frames, int p_count, float *r_output);
+	int process_mono(const float *p_samples, int p_count, float *r_output);
+};
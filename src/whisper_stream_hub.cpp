@@ -0,0 +1,377 @@
+#include "whisper_stream_hub.h"
+
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/classes/time.hpp>
+using namespace godot;
+
+#include <cstring>
+
+/* --- WhisperStreamHub implementation --- */
+
+WhisperStreamHub::WhisperStreamHub() {
+	mtx.instantiate();
+}
+
+WhisperStreamHub::~WhisperStreamHub() {
+	for (KeyValue<int, Stream *> &E : streams) {
+		if (E.value->job.is_valid()) {
+			E.value->job->cancel();
+		}
+		memdelete(E.value);
+	}
+	streams.clear();
+
+	// released while the members are still alive, a WhisperFull freed with it completes its jobs into this hub
+	whisper.unref();
+}
+
+void WhisperStreamHub::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("set_whisper", "whisper"), &WhisperStreamHub::set_whisper);
+	ClassDB::bind_method(D_METHOD("get_whisper"), &WhisperStreamHub::get_whisper);
+
+	ClassDB::bind_method(D_METHOD("set_step_ms", "step_ms"), &WhisperStreamHub::set_step_ms);
+	ClassDB::bind_method(D_METHOD("get_step_ms"), &WhisperStreamHub::get_step_ms);
+
+	ClassDB::bind_method(D_METHOD("set_length_ms", "length_ms"), &WhisperStreamHub::set_length_ms);
+	ClassDB::bind_method(D_METHOD("get_length_ms"), &WhisperStreamHub::get_length_ms);
+
+	ClassDB::bind_method(D_METHOD("set_keep_ms", "keep_ms"), &WhisperStreamHub::set_keep_ms);
+	ClassDB::bind_method(D_METHOD("get_keep_ms"), &WhisperStreamHub::get_keep_ms);
+
+	ClassDB::bind_method(D_METHOD("set_priority_aging_ms", "priority_aging_ms"), &WhisperStreamHub::set_priority_aging_ms);
+	ClassDB::bind_method(D_METHOD("get_priority_aging_ms"), &WhisperStreamHub::get_priority_aging_ms);
+
+	ClassDB::bind_method(D_METHOD("add_stream", "stream_id", "priority"), &WhisperStreamHub::add_stream, DEFVAL(0));
+	ClassDB::bind_method(D_METHOD("remove_stream", "stream_id"), &WhisperStreamHub::remove_stream);
+	ClassDB::bind_method(D_METHOD("has_stream", "stream_id"), &WhisperStreamHub::has_stream);
+	ClassDB::bind_method(D_METHOD("get_stream_count"), &WhisperStreamHub::get_stream_count);
+
+	ClassDB::bind_method(D_METHOD("set_stream_priority", "stream_id", "priority"), &WhisperStreamHub::set_stream_priority);
+	ClassDB::bind_method(D_METHOD("get_stream_priority", "stream_id"), &WhisperStreamHub::get_stream_priority);
+
+	ClassDB::bind_method(D_METHOD("push_audio", "stream_id", "samples"), &WhisperStreamHub::push_audio);
+	ClassDB::bind_method(D_METHOD("get_in_flight_count"), &WhisperStreamHub::get_in_flight_count);
+
+	ClassDB::bind_method(D_METHOD("_on_job_completed", "stream_id"), &WhisperStreamHub::_on_job_completed);
+
+	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "whisper", PROPERTY_HINT_RESOURCE_TYPE, "WhisperFull"), "set_whisper", "get_whisper");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "step_ms", PROPERTY_HINT_RANGE, "500,10000,100"), "set_step_ms", "get_step_ms");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "length_ms", PROPERTY_HINT_RANGE, "1000,30000,100"), "set_length_ms", "get_length_ms");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "keep_ms", PROPERTY_HINT_RANGE, "0,2000,50"), "set_keep_ms", "get_keep_ms");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "priority_aging_ms", PROPERTY_HINT_RANGE, "0,60000,100"), "set_priority_aging_ms", "get_priority_aging_ms");
+
+	ADD_SIGNAL(MethodInfo("stream_text", PropertyInfo(Variant::INT, "stream_id"), PropertyInfo(Variant::STRING, "text")));
+	ADD_SIGNAL(MethodInfo("stream_segment", PropertyInfo(Variant::INT, "stream_id"), PropertyInfo(Variant::OBJECT, "segment", PROPERTY_HINT_RESOURCE_TYPE, "WhisperSegment")));
+	ADD_SIGNAL(MethodInfo("stream_error", PropertyInfo(Variant::INT, "stream_id"), PropertyInfo(Variant::INT, "result")));
+}
+
+void WhisperStreamHub::_notification(int p_what) {
+	switch (p_what) {
+		case NOTIFICATION_READY: {
+			set_process_internal(true);
+		} break;
+		case NOTIFICATION_INTERNAL_PROCESS: {
+			_dispatch();
+		} break;
+	}
+}
+
+/* --- property getters/setters --- */
+
+void WhisperStreamHub::set_whisper(const Ref<WhisperFull> &p_whisper) {
+	if (in_flight > 0) {
+		ERR_PRINT("[WhisperStreamHub] cannot change whisper while windows are being transcribed");
+		return;
+	}
+	whisper = p_whisper;
+}
+
+Ref<WhisperFull> WhisperStreamHub::get_whisper() const {
+	return whisper;
+}
+
+void WhisperStreamHub::set_step_ms(int p_step_ms) {
+	step_ms = CLAMP(p_step_ms, 500, 10000);
+}
+
+int WhisperStreamHub::get_step_ms() const {
+	return step_ms;
+}
+
+void WhisperStreamHub::set_length_ms(int p_length_ms) {
+	length_ms = CLAMP(p_length_ms, 1000, 30000);
+}
+
+int WhisperStreamHub::get_length_ms() const {
+	return length_ms;
+}
+
+void WhisperStreamHub::set_keep_ms(int p_keep_ms) {
+	keep_ms = CLAMP(p_keep_ms, 0, 2000);
+}
+
+int WhisperStreamHub::get_keep_ms() const {
+	return keep_ms;
+}
+
+void WhisperStreamHub::set_priority_aging_ms(int p_priority_aging_ms) {
+	priority_aging_ms = CLAMP(p_priority_aging_ms, 0, 60000);
+}
+
+int WhisperStreamHub::get_priority_aging_ms() const {
+	return priority_aging_ms;
+}
+
+/* --- stream management --- */
+
+WhisperStreamHub::Stream *WhisperStreamHub::_get_or_add_stream(int p_stream_id) {
+	// must be called with mtx locked
+	HashMap<int, Stream *>::Iterator E = streams.find(p_stream_id);
+	if (E) {
+		return E->value;
+	}
+
+	Stream *stream = memnew(Stream);
+	stream->id = p_stream_id;
+	streams.insert(p_stream_id, stream);
+	return stream;
+}
+
+void WhisperStreamHub::add_stream(int p_stream_id, int p_priority) {
+	mtx->lock();
+	_get_or_add_stream(p_stream_id)->priority = p_priority;
+	mtx->unlock();
+}
+
+void WhisperStreamHub::remove_stream(int p_stream_id) {
+	mtx->lock();
+	HashMap<int, Stream *>::Iterator E = streams.find(p_stream_id);
+	if (E) {
+		// the completion of a window in flight is ignored once its stream is gone
+		if (E->value->job.is_valid()) {
+			E->value->job->cancel();
+		}
+		memdelete(E->value);
+		streams.erase(p_stream_id);
+	}
+	mtx->unlock();
+}
+
+bool WhisperStreamHub::has_stream(int p_stream_id) const {
+	mtx->lock();
+	bool result = streams.has(p_stream_id);
+	mtx->unlock();
+	return result;
+}
+
+int WhisperStreamHub::get_stream_count() const {
+	mtx->lock();
+	int count = streams.size();
+	mtx->unlock();
+	return count;
+}
+
+void WhisperStreamHub::set_stream_priority(int p_stream_id, int p_priority) {
+	mtx->lock();
+	HashMap<int, Stream *>::Iterator E = streams.find(p_stream_id);
+	if (E) {
+		E->value->priority = p_priority;
+	}
+	mtx->unlock();
+}
+
+int WhisperStreamHub::get_stream_priority(int p_stream_id) const {
+	mtx->lock();
+	HashMap<int, Stream *>::ConstIterator E = streams.find(p_stream_id);
+	int priority = E ? E->value->priority : 0;
+	mtx->unlock();
+	return priority;
+}
+
+void WhisperStreamHub::push_audio(int p_stream_id, const PackedFloat32Array &p_samples) {
+	const int whisper_sample_rate = 16000;
+	const int n_samples_step = int(float(step_ms) * whisper_sample_rate / 1000.0f);
+	const int n_samples_len = int(float(length_ms) * whisper_sample_rate / 1000.0f);
+
+	mtx->lock();
+	Stream *stream = _get_or_add_stream(p_stream_id);
+
+	uint32_t offset = stream->pending.size();
+	stream->pending.resize(offset + p_samples.size());
+	memcpy(stream->pending.ptr() + offset, p_samples.ptr(), p_samples.size() * sizeof(float));
+
+	// a stream that falls behind by more than a window loses its oldest audio instead of growing forever.
+	// not while a window is being queued, its audio is removed from the front once it is
+	if ((int)stream->pending.size() > n_samples_len && !stream->submitting) {
+		int drop = stream->pending.size() - n_samples_len;
+		memmove(stream->pending.ptr(), stream->pending.ptr() + drop, n_samples_len * sizeof(float));
+		stream->pending.resize(n_samples_len);
+	}
+
+	if (stream->ready_usec == 0 && (int)stream->pending.size() >= n_samples_step) {
+		stream->ready_usec = Time::get_singleton()->get_ticks_usec();
+	}
+	mtx->unlock();
+}
+
+int WhisperStreamHub::get_in_flight_count() const {
+	return in_flight;
+}
+
+/* --- scheduling --- */
+
+// runs every frame on the main thread, fills the free worker slots with the most urgent windows
+void WhisperStreamHub::_dispatch() {
+	if (whisper.is_null() || whisper->get_model().is_null() || whisper->get_model()->get_bin_path().is_empty()) {
+		return;
+	}
+
+	// jobs beyond the worker count would only queue up in WhisperFull in submission order
+	const int max_in_flight = whisper->get_n_workers();
+	const uint64_t now = Time::get_singleton()->get_ticks_usec();
+
+	while (in_flight < max_in_flight) {
+		mtx->lock();
+
+		// waiting counts as priority, ties go to the window waiting longest
+		Stream *best = nullptr;
+		int64_t best_score = 0;
+		for (const KeyValue<int, Stream *> &E : streams) {
+			Stream *stream = E.value;
+			if (stream->ready_usec == 0 || stream->job.is_valid() || stream->submitting) {
+				continue;
+			}
+
+			int64_t score = (int64_t)stream->priority * 1000000;
+			if (priority_aging_ms > 0) {
+				score += (int64_t)(now - MIN(now, stream->ready_usec)) * 1000 / priority_aging_ms;
+			}
+
+			if (best == nullptr || score > best_score || (score == best_score && stream->ready_usec < best->ready_usec)) {
+				best = stream;
+				best_score = score;
+			}
+		}
+
+		if (best == nullptr) {
+			mtx->unlock();
+			break;
+		}
+
+		int stream_id = best->id;
+		int n_samples_new = best->pending.size();
+		PackedFloat32Array samples = _make_window(best);
+		best->submitting = true;
+		mtx->unlock();
+
+		// queued without holding mtx, so push_audio callers on other threads don't wait for it
+		Ref<WhisperJob> job = whisper->transcribe_async(samples);
+
+		mtx->lock();
+		bool queued = _finish_submit(stream_id, samples, n_samples_new, job);
+		mtx->unlock();
+
+		if (!queued) {
+			break;
+		}
+	}
+}
+
+// same windowing as WhisperMicrophoneTranscriber: the tail of the previous window, then the new audio
+PackedFloat32Array WhisperStreamHub::_make_window(const Stream *p_stream) const {
+	// must be called with mtx locked
+	const int whisper_sample_rate = 16000;
+	const int n_samples_len = int(float(length_ms) * whisper_sample_rate / 1000.0f);
+	const int n_samples_keep = int(float(keep_ms) * whisper_sample_rate / 1000.0f);
+
+	int n_samples_new = p_stream->pending.size();
+	int n_samples_old = p_stream->window.size();
+	int n_samples_take = MIN(n_samples_old, MAX(0, n_samples_keep + n_samples_len - n_samples_new));
+
+	PackedFloat32Array samples;
+	samples.resize(n_samples_take + n_samples_new);
+	float *samples_ptr = samples.ptrw();
+	memcpy(samples_ptr, p_stream->window.ptr() + n_samples_old - n_samples_take, n_samples_take * sizeof(float));
+	memcpy(samples_ptr + n_samples_take, p_stream->pending.ptr(), n_samples_new * sizeof(float));
+
+	return samples;
+}
+
+// returns false when the window couldn't be queued, its audio then stays pending
+bool WhisperStreamHub::_finish_submit(int p_stream_id, const PackedFloat32Array &p_samples, int p_n_samples_new, const Ref<WhisperJob> &p_job) {
+	// must be called with mtx locked
+	const int whisper_sample_rate = 16000;
+	const int n_samples_step = int(float(step_ms) * whisper_sample_rate / 1000.0f);
+
+	// a stream removed (or removed and added again) meanwhile is no longer submitting
+	HashMap<int, Stream *>::Iterator E = streams.find(p_stream_id);
+	Stream *stream = E && E->value->submitting ? E->value : nullptr;
+	if (stream != nullptr) {
+		stream->submitting = false;
+	}
+
+	if (p_job.is_null()) {
+		return false;
+	}
+
+	if (stream == nullptr) {
+		p_job->cancel();
+		return true;
+	}
+
+	// the window is only advanced once it is queued, audio pushed meanwhile stays pending
+	stream->window.resize(p_samples.size());
+	memcpy(stream->window.ptr(), p_samples.ptr(), p_samples.size() * sizeof(float));
+
+	int n_samples_left = stream->pending.size() - p_n_samples_new;
+	memmove(stream->pending.ptr(), stream->pending.ptr() + p_n_samples_new, n_samples_left * sizeof(float));
+	stream->pending.resize(n_samples_left);
+	stream->ready_usec = n_samples_left >= n_samples_step ? Time::get_singleton()->get_ticks_usec() : 0;
+
+	stream->job = p_job;
+	in_flight++;
+
+	// only the id is bound, the job is taken from the stream. binding the job into its own signal would keep it alive
+	p_job->connect("completed", Callable(this, "_on_job_completed").bind(p_stream_id), CONNECT_ONE_SHOT);
+	return true;
+}
+
+void WhisperStreamHub::_on_job_completed(int p_stream_id) {
+	Ref<WhisperJob> job;
+
+	mtx->lock();
+	in_flight--;
+
+	// the job of a removed stream was canceled and is only counted out
+	HashMap<int, Stream *>::Iterator E = streams.find(p_stream_id);
+	if (E && E->value->job.is_valid() && E->value->job->is_done()) {
+		job = E->value->job;
+		E->value->job.unref();
+	}
+	mtx->unlock();
+
+	if (job.is_null() || job->get_status() == WhisperJob::STATUS_CANCELED) {
+		return;
+	}
+
+	if (job->get_result() != 0) {
+		emit_signal("stream_error", p_stream_id, job->get_result());
+		return;
+	}
+
+	String text = job->get_text();
+	if (!text.strip_edges().is_empty()) {
+		emit_signal("stream_text", p_stream_id, text);
+	}
+
+	TypedArray<WhisperSegment> segments = job->get_segments();
+	for (int i = 0; i < segments.size(); i++) {
+		Ref<WhisperSegment> segment = segments[i];
+		if (segment.is_valid() && !segment->get_text().strip_edges().is_empty()) {
+			emit_signal("stream_segment", p_stream_id, segment);
+		}
+	}
+
+	// the freed slot is filled right away instead of on the next frame
+	_dispatch();
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <godot_cpp/classes/node.hpp>
+#include <godot_cpp/classes/mutex.hpp>
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/variant/packed_float32_array.hpp>
+using namespace godot;
+
+#include "whisper_full.h"
+
+// this class transcribes any number of concurrent audio streams (e.g. one per speaker) with a single model.
+// audio is pushed per stream id and cut into sliding windows like WhisperMicrophoneTranscriber does,
+// windows are then scheduled onto the async job pool of one WhisperFull, so memory and threads scale with
+// its n_workers instead of with the number of streams.
+// ready windows are dispatched by stream priority plus one level for every priority_aging_ms they have
+// been waiting, so a busy high priority stream delays the others but never starves them.
+// each stream has at most one window in flight so its results stay in order.
+class WhisperStreamHub : public Node {
+	GDCLASS(WhisperStreamHub, Node);
+
+	struct Stream {
+		int id = 0;
+		int priority = 0;
+		LocalVector<float> pending; // audio pushed since the last window
+		LocalVector<float> window; // last window, its tail is kept for the next one
+		Ref<WhisperJob> job; // window in flight
+		bool submitting = false; // window being queued by _dispatch, without mtx held
+		uint64_t ready_usec = 0; // when pending reached a full step, 0 while it hasn't
+	};
+
+	Ref<WhisperFull> whisper;
+
+	// windowing parameters
+	int step_ms = 3000;
+	int length_ms = 10000;
+	int keep_ms = 200;
+
+	// scheduling, 0 dispatches by priority alone
+	int priority_aging_ms = 1000;
+
+	// streams (protected by mutex, push_audio may be called from any thread)
+	Ref<Mutex> mtx;
+	HashMap<int, Stream *> streams;
+	int in_flight = 0;
+
+	Stream *_get_or_add_stream(int p_stream_id);
+	void _dispatch();
+	PackedFloat32Array _make_window(const Stream *p_stream) const;
+	bool _finish_submit(int p_stream_id, const PackedFloat32Array &p_samples, int p_n_samples_new, const Ref<WhisperJob> &p_job);
+	void _on_job_completed(int p_stream_id);
+
+protected:
+	static void _bind_methods();
+	void _notification(int p_what);
+
+public:
+	void set_whisper(const Ref<WhisperFull> &p_whisper);
+	Ref<WhisperFull> get_whisper() const;
+
+	void set_step_ms(int p_step_ms);
+	int get_step_ms() const;
+
+	void set_length_ms(int p_length_ms);
+	int get_length_ms() const;
+
+	void set_keep_ms(int p_keep_ms);
+	int get_keep_ms() const;
+
+	void set_priority_aging_ms(int p_priority_aging_ms);
+	int get_priority_aging_ms() const;
+
+	// stream management
+	void add_stream(int p_stream_id, int p_priority = 0);
+	void remove_stream(int p_stream_id);
+	bool has_stream(int p_stream_id) const;
+	int get_stream_count() const;
+
+	void set_stream_priority(int p_stream_id, int p_priority);
+	int get_stream_priority(int p_stream_id) const;
+
+	// 16kHz mono samples, unknown streams are added with priority 0
+	void push_audio(int p_stream_id, const PackedFloat32Array &p_samples);
+	int get_in_flight_count() const;
+
+	WhisperStreamHub();
+	~WhisperStreamHub();
+};
@@ -0,0 +1,89 @@
+#include "whisper_voice_detector.h"
+
+#include <godot_cpp/core/math.hpp>
+using namespace godot;
+
+#include <cstring>
+
+void WhisperVoiceDetector::set_hangover_ms(int p_hangover_ms) {
+	hangover_frames = MAX(1, p_hangover_ms / 20);
+}
+
+int WhisperVoiceDetector::get_hangover_ms() const {
+	return hangover_frames * 20;
+}
+
+void WhisperVoiceDetector::reset() {
+	frame_fill = 0;
+	noise_floor = 0.0f;
+	speaking = false;
+	silent_frames = 0;
+}
+
+bool WhisperVoiceDetector::_is_speech_frame(const float *p_frame) {
+	float energy = 0.0f;
+	int zero_crossings = 0;
+	for (int i = 0; i < FRAME_SIZE; i++) {
+		energy += p_frame[i] * p_frame[i];
+		zero_crossings += (i > 0) && ((p_frame[i] >= 0.0f) != (p_frame[i - 1] >= 0.0f));
+	}
+	energy /= FRAME_SIZE;
+	float zero_crossing_rate = float(zero_crossings) / FRAME_SIZE;
+
+	if (noise_floor <= 0.0f) {
+		noise_floor = MAX(energy, min_energy);
+	}
+
+	bool speech = energy > min_energy && energy > noise_floor * energy_ratio && zero_crossing_rate < max_zero_crossing_rate;
+
+	// the floor falls quickly and rises slowly, and isn't pulled up by speech
+	if (energy < noise_floor) {
+		noise_floor = noise_floor * 0.9f + energy * 0.1f;
+	} else if (!speech) {
+		noise_floor = noise_floor * 0.995f + energy * 0.005f;
+	}
+	noise_floor = MAX(noise_floor, min_energy * 0.1f);
+
+	return speech;
+}
+
+WhisperVoiceDetector::Event WhisperVoiceDetector::_update(bool p_speech_frame) {
+	if (p_speech_frame) {
+		silent_frames = 0;
+		if (!speaking) {
+			speaking = true;
+			return EVENT_SPEECH_START;
+		}
+		return EVENT_NONE;
+	}
+
+	if (speaking && ++silent_frames >= hangover_frames) {
+		speaking = false;
+		return EVENT_SPEECH_END;
+	}
+	return EVENT_NONE;
+}
+
+int WhisperVoiceDetector::process(const float *p_samples, int p_count, Event &r_event) {
+	r_event = EVENT_NONE;
+
+	int i = 0;
+	while (i < p_count) {
+		int n = MIN(p_count - i, FRAME_SIZE - frame_fill);
+		memcpy(frame + frame_fill, p_samples + i, n * sizeof(float));
+		frame_fill += n;
+		i += n;
+
+		if (frame_fill < FRAME_SIZE) {
+			break;
+		}
+		frame_fill = 0;
+
+		r_event = _update(_is_speech_frame(frame));
+		if (r_event != EVENT_NONE) {
+			break;
+		}
+	}
+
+	return i;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <godot_cpp/templates/local_vector.hpp>
+using namespace godot;
+
+// this class is a cheap streaming voice activity detector for 16kHz mono audio.
+// it classifies 20ms frames by their energy against an adaptive noise floor and by their
+// zero-crossing rate (broadband noise crosses zero far more often than voiced speech),
+// then holds the speech state for a hangover period so short pauses don't split utterances.
+// it costs a few operations per sample, so it can gate audio before it ever reaches whisper_full.
+class WhisperVoiceDetector {
+public:
+	enum Event {
+		EVENT_NONE,
+		EVENT_SPEECH_START,
+		EVENT_SPEECH_END,
+	};
+
+	static const int FRAME_SIZE = 320; // 20ms at 16kHz
+
+private:
+	// settings
+	float energy_ratio = 3.0f; // how far above the noise floor a frame must be to count as speech
+	float min_energy = 1e-4f; // absolute floor for the frame energy (mean square), below is always silence
+	float max_zero_crossing_rate = 0.35f;
+	int hangover_frames = 25; // 500ms
+
+	// state
+	float frame[FRAME_SIZE];
+	int frame_fill = 0;
+	float noise_floor = 0.0f;
+	bool speaking = false;
+	int silent_frames = 0;
+
+	bool _is_speech_frame(const float *p_frame);
+	Event _update(bool p_speech_frame);
+
+public:
+	void set_energy_ratio(float p_energy_ratio) { energy_ratio = p_energy_ratio; }
+	float get_energy_ratio() const { return energy_ratio; }
+
+	void set_min_energy(float p_min_energy) { min_energy = p_min_energy; }
+	float get_min_energy() const { return min_energy; }
+
+	void set_hangover_ms(int p_hangover_ms);
+	int get_hangover_ms() const;
+
+	bool is_speaking() const { return speaking; }
+
+	// feeds samples through the detector until the speech state changes.
+	// returns how many samples were consumed and sets r_event to the change that stopped it,
+	// or to EVENT_NONE if all of them were consumed without one
+	int process(const float *p_samples, int p_count, Event &r_event);
+
+	void reset();
+};